@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_ALLOCATESERIALIZEDNETWORK_H
+#define SHAREMIND_MOD_ALGORITHMS_ALLOCATESERIALIZEDNETWORK_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <sharemind/module-apis/api_0x1.h>
+
+
+/**
+  \brief Allocates public memory for the serialization of the network in
+         words of type Word, serializes the network into it and returns the
+         handle of the memory in returnValue.
+  \details This saves SecreC code from first querying the size of the
+           network and allocating the memory itself.
+*/
+template <typename Word, typename Network>
+SharemindModuleApi0x1Error allocateSerializedNetwork(
+        SharemindModuleApi0x1SyscallContext * const c,
+        Network const & network,
+        SharemindCodeBlock * const returnValue) noexcept
+        __attribute__ ((visibility("internal")));
+
+template <typename Word, typename Network>
+SharemindModuleApi0x1Error allocateSerializedNetwork(
+        SharemindModuleApi0x1SyscallContext * const c,
+        Network const & network,
+        SharemindCodeBlock * const returnValue) noexcept
+{
+    assert(c);
+    assert(returnValue);
+    std::size_t const size = network.serializedSize();
+    if (size > std::numeric_limits<uint64_t>::max() / sizeof(Word))
+        return SHAREMIND_MODULE_API_0x1_OUT_OF_MEMORY;
+
+    const uint64_t mem_hndl = (*c->publicAlloc)(c, size * sizeof(Word));
+    if (!mem_hndl)
+        return SHAREMIND_MODULE_API_0x1_OUT_OF_MEMORY;
+    Word * const mem_ptr =
+            static_cast<Word *>((*c->publicMemPtrData)(c, mem_hndl));
+    assert(mem_ptr);
+    network.serialize(mem_ptr);
+    returnValue->uint64[0u] = mem_hndl;
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_ALLOCATESERIALIZEDNETWORK_H */
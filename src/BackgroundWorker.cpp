@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#include "BackgroundWorker.h"
+
+#include <utility>
+
+
+BackgroundWorker::~BackgroundWorker() noexcept {
+    {
+        std::lock_guard<std::mutex> const lock(m_mutex);
+        m_stop = true;
+        m_tasks.clear();
+    }
+    m_condition.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void BackgroundWorker::enqueue(Task task) {
+    {
+        std::lock_guard<std::mutex> const lock(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+        if (!m_thread.joinable())
+            m_thread = std::thread(&BackgroundWorker::run, this);
+    }
+    m_condition.notify_one();
+}
+
+void BackgroundWorker::run() noexcept {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_condition.wait(lock, [this]{ return m_stop || !m_tasks.empty(); });
+        if (m_stop)
+            return;
+        Task task(std::move(m_tasks.front()));
+        m_tasks.pop_front();
+        lock.unlock();
+        try {
+            task();
+        } catch (...) {
+            // Tasks are best-effort, their failures are ignored.
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_BACKGROUNDWORKER_H
+#define SHAREMIND_MOD_ALGORITHMS_BACKGROUNDWORKER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+/**
+  \brief A thread which executes queued tasks in the background.
+  \details The thread is started when the first task is queued. Exceptions
+           thrown by tasks are ignored. On destruction, tasks which have not
+           been started yet are discarded and the task being executed is
+           waited for.
+*/
+class __attribute__ ((visibility("internal"))) BackgroundWorker {
+
+public: /* Types: */
+
+    using Task = std::function<void ()>;
+
+public: /* Methods: */
+
+    BackgroundWorker() = default;
+    BackgroundWorker(BackgroundWorker const &) = delete;
+    BackgroundWorker & operator=(BackgroundWorker const &) = delete;
+    ~BackgroundWorker() noexcept;
+
+    void enqueue(Task task);
+
+private: /* Methods: */
+
+    void run() noexcept;
+
+private: /* Fields: */
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Task> m_tasks;
+    bool m_stop = false;
+    std::thread m_thread;
+
+}; /* class BackgroundWorker { */
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_BACKGROUNDWORKER_H */
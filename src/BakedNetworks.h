@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_BAKEDNETWORKS_H
+#define SHAREMIND_MOD_ALGORITHMS_BAKEDNETWORKS_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*
+  The networks of the most common sizes are generated at build time by the
+  BakeNetworks tool in codegen/, and compiled into the module as read-only
+  tables, so that they are available without generating, caching or locking.
+*/
+
+/** The largest number of elements of the networks baked into the module. */
+constexpr std::size_t maxBakedNetworkElements = 64u;
+
+/** The largest k of the top-k sorting networks baked into the module. */
+constexpr std::size_t maxBakedTopKSortingNetworkK = 8u;
+
+/** A serialized network, or no network if data is null. */
+struct BakedNetwork {
+    std::uint64_t const * data;
+    std::size_t size;
+};
+
+/**
+  \returns the network of the given SortingNetworkAlgorithm, or no network if
+           it is not baked into the module.
+*/
+BakedNetwork bakedSortingNetwork(std::uint64_t algorithm,
+                                 std::size_t elements) noexcept
+        __attribute__ ((visibility("internal")));
+
+BakedNetwork bakedMergingNetwork(std::size_t elements) noexcept
+        __attribute__ ((visibility("internal")));
+
+BakedNetwork bakedTopKSortingNetwork(std::size_t elements,
+                                     std::size_t k) noexcept
+        __attribute__ ((visibility("internal")));
+
+/**
+  \returns whether BakeNetworks found BitonicSortingNetwork::modelMetrics() to
+           agree with the networks generated by libsortnetwork.
+*/
+bool bitonicMetricsModelVerified() noexcept
+        __attribute__ ((visibility("internal")));
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_BAKEDNETWORKS_H */
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#include "ImplicitSortingNetwork.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace /* anonymous */ {
+
+/** \returns the number of x < m with x % (2d) < d. */
+std::size_t countLowerHalves(std::size_t const m, std::size_t const d) noexcept
+{ return (m / (2u * d)) * d + std::min(m % (2u * d), d); }
+
+/** \returns the number of x < m with x % (2d) >= d. */
+std::size_t countUpperHalves(std::size_t const m, std::size_t const d) noexcept
+{ return (m / (2u * d)) * d + (m % (2u * d) > d ? m % (2u * d) - d : 0u); }
+
+/**
+  \returns the number of comparators in the given stage of the bitonic merge
+           sort of n elements.
+*/
+std::size_t bitonicStageComparators(std::size_t const n,
+                                    std::size_t const block,
+                                    std::size_t const d) noexcept
+{
+    if (2u * d == block) {
+        // Full blocks and the mirrored pairs within the last partial block:
+        std::size_t const rest = n % block;
+        return (n / block) * d + (rest > d ? rest - d : 0u);
+    }
+    return n > d ? countLowerHalves(n - d, d) : 0u;
+}
+
+/**
+  \returns the number of comparators in the given stage of the odd-even merge
+           sort of n elements.
+*/
+std::size_t oddEvenStageComparators(std::size_t const n,
+                                    std::size_t const block,
+                                    std::size_t const d) noexcept
+{
+    if (n <= d)
+        return 0u;
+    std::size_t const m = n - d;
+    if (d == block)
+        return countLowerHalves(m, d);
+    // Each full double block has block / d - 1 pairs of d comparators:
+    return (m / (2u * block)) * (block - d)
+           + countUpperHalves(std::min(m % (2u * block), 2u * block - d), d);
+}
+
+void checkedAdd(std::size_t & a, std::size_t const b) {
+    if (b > std::numeric_limits<std::size_t>::max() - a)
+        throw std::length_error("Too many network inputs!");
+    a += b;
+}
+
+} /* namespace anonymous { */
+
+
+ImplicitSortingNetwork::ImplicitSortingNetwork(Algorithm const algorithm,
+                                               std::size_t const elements)
+    : m_algorithm(algorithm)
+    , m_elements(elements)
+    , m_serializedSize(1u)
+{
+    // Otherwise the serialized size would overflow anyway:
+    if (elements > std::numeric_limits<std::size_t>::max() / 8u)
+        throw std::length_error("Too many network inputs!");
+    auto const addStage =
+            [this](std::size_t const block,
+                   std::size_t const d,
+                   std::size_t const comparators)
+            {
+                if (!comparators)
+                    return;
+                m_stages.push_back(
+                            Stage{block, d, comparators, m_serializedSize});
+                checkedAdd(m_serializedSize, 1u);
+                checkedAdd(m_serializedSize, 4u * comparators);
+            };
+    if (algorithm == BITONIC_MERGE_SORT) {
+        for (std::size_t block = 2u; block / 2u < elements; block *= 2u)
+            for (std::size_t d = block / 2u; d > 0u; d /= 2u)
+                addStage(block, d, bitonicStageComparators(elements, block, d));
+    } else {
+        for (std::size_t block = 1u; block < elements; block *= 2u)
+            for (std::size_t d = block; d > 0u; d /= 2u)
+                addStage(block, d, oddEvenStageComparators(elements, block, d));
+    }
+}
+
+NetworkMetrics ImplicitSortingNetwork::metrics() const noexcept {
+    NetworkMetrics r{numStages(), numComparators(), 0u};
+    for (auto const & stage : m_stages)
+        r.maxStageWidth = std::max<std::uint64_t>(r.maxStageWidth,
+                                                  stage.comparators);
+    return r;
+}
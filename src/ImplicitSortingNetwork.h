@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_IMPLICITSORTINGNETWORK_H
+#define SHAREMIND_MOD_ALGORITHMS_IMPLICITSORTINGNETWORK_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "NetworkCache.h"
+#include "NetworkMetrics.h"
+#include "ParallelSerialization.h"
+
+
+/**
+  \brief A sorting network whose comparators are computed from closed-form
+         formulas directly into the output buffer when it is serialized.
+  \details Only the number of comparators and the offset of each stage in the
+           serialized form are kept, i.e. O(log^2 n) words, so serializing even
+           huge networks needs no memory beyond the output buffer, and stages
+           may be serialized independently of each other.
+
+           The networks are Batcher's networks for the next power of two
+           without the comparators on the missing elements. Since every
+           comparator places its minimum onto its lower wire, the missing
+           elements behave as if they were larger than all others. Stages
+           which would be left without comparators are omitted.
+
+           The networks are serialized in the same format as
+           SerializableNetwork.
+*/
+class __attribute__ ((visibility("internal"))) ImplicitSortingNetwork {
+
+public: /* Types: */
+
+    enum Algorithm {
+        /**
+          Bitonic merge sort in which the first step of every merge compares
+          the elements of a block in mirrored order, so that all comparators
+          sort in ascending order.
+        */
+        BITONIC_MERGE_SORT,
+        /** Batcher's odd-even merge sort. */
+        ODD_EVEN_MERGE_SORT
+    };
+
+private: /* Types: */
+
+    /**
+      \brief A stage, which compares elements at the given distance.
+      \details In the bitonic merge sort, the stage belongs to the merge of
+               blocks of blockSize elements, and mirrors the elements of the
+               blocks if the distance is half of the block size. In the
+               odd-even merge sort, the stage belongs to the merge of runs of
+               blockSize elements.
+    */
+    struct Stage {
+        std::size_t blockSize;
+        std::size_t distance;
+        std::size_t comparators;
+        /** The offset of the stage in the serialized form. */
+        std::size_t offset;
+    };
+
+public: /* Methods: */
+
+    /**
+       \throws std::length_error if the serialized network would not fit into
+                                 memory.
+    */
+    ImplicitSortingNetwork(Algorithm algorithm, std::size_t elements);
+
+    std::size_t numStages() const noexcept { return m_stages.size(); }
+
+    std::size_t numComparators() const noexcept
+    { return (serializedSize() - 1u - numStages()) / 4u; }
+
+    std::size_t serializedSize() const noexcept { return m_serializedSize; }
+
+    /**
+       \returns the size of the serialization of stages
+                 [firstStage, lastStage) in the same format as serialize().
+    */
+    std::size_t serializedStagesSize(std::size_t const firstStage,
+                                     std::size_t const lastStage)
+            const noexcept
+    {
+        assert(firstStage <= lastStage);
+        assert(lastStage <= numStages());
+        return 1u + stageOffset(lastStage) - stageOffset(firstStage);
+    }
+
+    /**
+       \returns whether all numbers in the serialized form of this network fit
+                 into 32-bit words, i.e. whether serialize() may be called with
+                 a std::uint32_t buffer.
+    */
+    bool fitsCompactSerialization() const noexcept {
+        return m_elements - 1u <= std::numeric_limits<std::uint32_t>::max()
+               && numStages() <= std::numeric_limits<std::uint32_t>::max();
+    }
+
+    NetworkMetrics metrics() const noexcept;
+
+    /** \returns the memory used by this network in bytes. */
+    std::size_t memoryUsage() const noexcept
+    { return sizeof(*this) + m_stages.capacity() * sizeof(Stage); }
+
+    /**
+       \brief Serializes the network into a buffer of serializedSize() words.
+       \details Word may be std::uint64_t, or std::uint32_t for the compact
+                format if fitsCompactSerialization() holds.
+    */
+    template <typename Word>
+    void serialize(Word * ptr) const noexcept
+    { serializeStages(0u, numStages(), ptr); }
+
+    /**
+       \brief Serializes only the stages [firstStage, lastStage).
+       \details The output starts with the number of serialized stages, i.e.
+                the range is serialized as if it were a network by itself.
+    */
+    template <typename Word>
+    void serializeStages(std::size_t const firstStage,
+                         std::size_t const lastStage,
+                         Word * ptr) const noexcept
+    {
+        static_assert(std::is_same<Word, std::uint64_t>::value
+                      || std::is_same<Word, std::uint32_t>::value,
+                      "Only 64-bit and 32-bit words are supported!");
+        assert(firstStage <= lastStage);
+        assert(lastStage <= numStages());
+        assert(sizeof(Word) >= sizeof(std::size_t)
+               || fitsCompactSerialization());
+        (*ptr) = static_cast<Word>(lastStage - firstStage);
+        std::size_t const firstOffset = stageOffset(firstStage);
+        // The stages are independent, so large ones are computed in parallel:
+        parallelFor(lastStage - firstStage,
+                    serializationThreads(
+                        serializedStagesSize(firstStage, lastStage)),
+                    [this, firstStage, firstOffset, ptr](
+                            std::size_t const i) noexcept
+                    {
+                        auto const & stage = m_stages[firstStage + i];
+                        serializeStage(stage,
+                                       ptr + 1u + (stage.offset - firstOffset));
+                    });
+    }
+
+private: /* Methods: */
+
+    std::size_t stageOffset(std::size_t const stage) const noexcept {
+        return stage < numStages()
+               ? m_stages[stage].offset
+               : m_serializedSize;
+    }
+
+    /** Calls f(left, right) for every comparator of the stage in order. */
+    template <typename F>
+    void forEachComparator(Stage const & stage, F && f) const noexcept {
+        std::size_t const n = m_elements;
+        std::size_t const block = stage.blockSize;
+        std::size_t const d = stage.distance;
+        if (m_algorithm == BITONIC_MERGE_SORT && 2u * d == block) {
+            for (std::size_t first = 0u; first < n; first += block) {
+                // Pairs (first + t, first + block - 1 - t), for t < d:
+                std::size_t t = (first + block > n) ? first + block - n : 0u;
+                for (; t < d; ++t)
+                    f(first + t, first + block - 1u - t);
+            }
+        } else if (m_algorithm == BITONIC_MERGE_SORT || d == block) {
+            // Pairs (x, x + d) for x % (2d) < d:
+            for (std::size_t first = 0u; first + d < n; first += 2u * d)
+                for (std::size_t x = first; x < first + d && x + d < n; ++x)
+                    f(x, x + d);
+        } else {
+            /* Pairs (x, x + d) for x % (2d) >= d, except those crossing a
+               block boundary, i.e. for x % (2 * block) >= 2 * block - d: */
+            for (std::size_t b = 0u; b + d < n; b += 2u * block)
+                for (std::size_t first = b + d;
+                     first < b + 2u * block - d && first + d < n;
+                     first += 2u * d)
+                    for (std::size_t x = first;
+                         x < first + d && x + d < n;
+                         ++x)
+                        f(x, x + d);
+        }
+    }
+
+    template <typename Word>
+    void serializeStage(Stage const & stage, Word * const ptr) const noexcept {
+        std::size_t const c = stage.comparators;
+        ptr[0u] = static_cast<Word>(c);
+        Word * left = ptr + 1u;
+        forEachComparator(
+                    stage,
+                    [left, c](std::size_t const a, std::size_t const b) mutable
+                    {
+                        // The left and right inputs and the targets of the
+                        // minimum and the maximum:
+                        left[0u] = left[2u * c] = static_cast<Word>(a);
+                        left[c] = left[3u * c] = static_cast<Word>(b);
+                        ++left;
+                    });
+    }
+
+private: /* Fields: */
+
+    Algorithm const m_algorithm;
+    std::size_t const m_elements;
+    std::vector<Stage> m_stages;
+    std::size_t m_serializedSize;
+
+}; /* class ImplicitSortingNetwork { */
+
+class __attribute__ ((visibility("internal"))) ImplicitBitonicSortingNetwork
+        : public ImplicitSortingNetwork
+{
+
+public: /* Methods: */
+
+    ImplicitBitonicSortingNetwork(std::size_t const elements)
+        : ImplicitSortingNetwork(BITONIC_MERGE_SORT, elements)
+    {}
+
+}; /* class ImplicitBitonicSortingNetwork { */
+
+class __attribute__ ((visibility("internal")))
+        ImplicitOddEvenMergeSortingNetwork
+        : public ImplicitSortingNetwork
+{
+
+public: /* Methods: */
+
+    ImplicitOddEvenMergeSortingNetwork(std::size_t const elements)
+        : ImplicitSortingNetwork(ODD_EVEN_MERGE_SORT, elements)
+    {}
+
+}; /* class ImplicitOddEvenMergeSortingNetwork { */
+
+/**
+  \brief Provides implicit networks through the interface of
+         SortingNetworkGenerator, without caching or storing them.
+*/
+template <typename T>
+class __attribute__ ((visibility("internal")))
+        ImplicitSortingNetworkGenerator
+{
+
+public: /* Types: */
+
+    using CacheStatistics =
+            typename NetworkCache<std::size_t, T>::Statistics;
+
+public: /* Methods: */
+
+    std::shared_ptr<T const> getCachedOrGenerateAndCacheNetwork(
+            std::size_t const elements) const
+    { return std::make_shared<T const>(elements); }
+
+    std::shared_ptr<T const> getCachedOrGenerateNetwork(
+            std::size_t const elements) const
+    { return std::make_shared<T const>(elements); }
+
+    NetworkMetrics networkMetrics(std::size_t const elements) const
+    { return T(elements).metrics(); }
+
+    /** \returns statistics of an empty cache. */
+    CacheStatistics cacheStatistics() const noexcept
+    { return CacheStatistics{0u, 0u, 0u, 0u, 0u}; }
+
+}; /* class ImplicitSortingNetworkGenerator { */
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_IMPLICITSORTINGNETWORK_H */
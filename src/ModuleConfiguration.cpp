@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#include "ModuleConfiguration.h"
+
+#include <limits>
+#include <sstream>
+
+
+namespace /* anonymous */ {
+
+std::uint64_t parseNumber(std::string const & key,
+                          std::string const & digits,
+                          std::string const & value)
+{
+    if (digits.empty()
+        || digits.find_first_not_of("0123456789") != std::string::npos)
+        throw ModuleConfiguration::Exception(
+                "Invalid number given for " + key + ": " + value);
+
+    std::uint64_t r = 0u;
+    for (char const digit : digits) {
+        std::uint64_t const d = static_cast<std::uint64_t>(digit - '0');
+        if (r > (std::numeric_limits<std::uint64_t>::max() - d) / 10u)
+            throw ModuleConfiguration::Exception(
+                    "Number given for " + key + " is too large: " + value);
+        r = r * 10u + d;
+    }
+    return r;
+}
+
+std::size_t parseSize(std::string const & key, std::string const & value) {
+    std::size_t multiplier = 1u;
+    std::string digits(value);
+    if (!digits.empty()) {
+        switch (digits.back()) {
+            case 'K': multiplier = 1024u; break;
+            case 'M': multiplier = 1024u * 1024u; break;
+            case 'G': multiplier = 1024u * 1024u * 1024u; break;
+            default: break;
+        }
+        if (multiplier != 1u)
+            digits.pop_back();
+    }
+
+    auto const r = parseNumber(key, digits, value);
+    if (r > std::numeric_limits<std::size_t>::max() / multiplier)
+        throw ModuleConfiguration::Exception(
+                "Size given for " + key + " is too large: " + value);
+    return r * multiplier;
+}
+
+/** \returns the comma-separated items of the given value. */
+std::vector<std::string> splitList(std::string const & value) {
+    std::vector<std::string> r;
+    std::string::size_type start = 0u;
+    for (;;) {
+        auto const end(value.find(',', start));
+        r.emplace_back(value, start, end == std::string::npos
+                                     ? std::string::npos
+                                     : end - start);
+        if (end == std::string::npos)
+            return r;
+        start = end + 1u;
+    }
+}
+
+std::vector<std::uint64_t> parseSizeList(std::string const & key,
+                                         std::string const & value)
+{
+    std::vector<std::uint64_t> r;
+    for (auto const & item : splitList(value)) {
+        r.emplace_back(parseNumber(key, item, value));
+        if (r.back() < 1u)
+            throw ModuleConfiguration::Exception(
+                    "Sizes given for " + key + " must be positive: " + value);
+    }
+    return r;
+}
+
+std::vector<std::pair<std::uint64_t, std::uint64_t> > parseSizePairList(
+        std::string const & key,
+        std::string const & value)
+{
+    std::vector<std::pair<std::uint64_t, std::uint64_t> > r;
+    for (auto const & item : splitList(value)) {
+        auto const colonPos(item.find(':'));
+        if (colonPos == std::string::npos)
+            throw ModuleConfiguration::Exception(
+                    "Invalid pair given for " + key + ": " + item);
+        r.emplace_back(parseNumber(key, item.substr(0u, colonPos), value),
+                       parseNumber(key, item.substr(colonPos + 1u), value));
+        if (r.back().first < 1u || r.back().second < 1u)
+            throw ModuleConfiguration::Exception(
+                    "Sizes given for " + key + " must be positive: " + value);
+    }
+    return r;
+}
+
+} /* namespace anonymous { */
+
+
+ModuleConfiguration::ModuleConfiguration(char const * const conf) {
+    if (!conf)
+        return;
+
+    std::istringstream iss{std::string(conf)};
+    std::string option;
+    while (iss >> option) {
+        auto const eqPos(option.find('='));
+        if (eqPos == std::string::npos || eqPos == 0u)
+            throw Exception("Invalid configuration option: " + option);
+        std::string const key(option, 0u, eqPos);
+        std::string const value(option, eqPos + 1u);
+        if (key == "NetworkCacheSize") {
+            m_networkCacheSize = parseSize(key, value);
+        } else if (key == "NetworkCacheDirectory") {
+            m_networkCacheDirectory = value;
+        } else if (key == "PrewarmSortingNetworks") {
+            m_prewarmSortingNetworks = parseSizeList(key, value);
+        } else if (key == "PrewarmMergingNetworks") {
+            m_prewarmMergingNetworks = parseSizeList(key, value);
+        } else if (key == "PrewarmTopKSortingNetworks") {
+            m_prewarmTopKSortingNetworks = parseSizePairList(key, value);
+        } else {
+            throw Exception("Unknown configuration option: " + key);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_MODULECONFIGURATION_H
+#define SHAREMIND_MOD_ALGORITHMS_MODULECONFIGURATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+  \brief The module configuration, parsed from the configuration string given
+         to the module by the server.
+  \details The configuration string consists of whitespace-separated
+           Key=Value options. Sizes can be given in bytes, or with a K, M or
+           G suffix for kibibytes, mebibytes or gibibytes. Recognized options:
+
+             NetworkCacheSize - the maximum number of bytes of networks to keep
+                                cached by the module, in total for all kinds
+                                of networks (sorting, merging, top-k etc.)
+                                Least recently used networks of any kind are
+                                evicted to stay within this limit. Zero (the
+                                default) means no limit.
+             NetworkCacheDirectory - the directory where generated networks
+                                     are persisted across restarts and from
+                                     where they are memory-mapped. Empty (the
+                                     default) disables persisting networks.
+             PrewarmSortingNetworks - comma-separated sizes of sorting networks
+                                      to generate in the background when the
+                                      module is loaded, e.g. 1000,65536
+             PrewarmMergingNetworks - likewise for merging networks.
+             PrewarmTopKSortingNetworks - likewise for top-k sorting networks,
+                                          given as comma-separated n:k pairs,
+                                          e.g. 100000:10,100000:100
+*/
+class __attribute__ ((visibility("internal"))) ModuleConfiguration {
+
+public: /* Types: */
+
+    class Exception: public std::runtime_error {
+
+    public: /* Methods: */
+
+        using std::runtime_error::runtime_error;
+
+    };
+
+public: /* Methods: */
+
+    /**
+      \param[in] conf The configuration string, or nullptr for defaults.
+      \throws Exception if the configuration string is invalid.
+    */
+    explicit ModuleConfiguration(char const * conf);
+
+    std::size_t networkCacheSize() const noexcept
+    { return m_networkCacheSize; }
+
+    std::string const & networkCacheDirectory() const noexcept
+    { return m_networkCacheDirectory; }
+
+    std::vector<std::uint64_t> const & prewarmSortingNetworks() const noexcept
+    { return m_prewarmSortingNetworks; }
+
+    std::vector<std::uint64_t> const & prewarmMergingNetworks() const noexcept
+    { return m_prewarmMergingNetworks; }
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t> > const &
+    prewarmTopKSortingNetworks() const noexcept
+    { return m_prewarmTopKSortingNetworks; }
+
+private: /* Fields: */
+
+    std::size_t m_networkCacheSize = 0u;
+    std::string m_networkCacheDirectory;
+    std::vector<std::uint64_t> m_prewarmSortingNetworks;
+    std::vector<std::uint64_t> m_prewarmMergingNetworks;
+    std::vector<std::pair<std::uint64_t, std::uint64_t> >
+            m_prewarmTopKSortingNetworks;
+
+}; /* class ModuleConfiguration { */
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_MODULECONFIGURATION_H */
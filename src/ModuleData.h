@@ -20,14 +20,112 @@
 #ifndef SHAREMIND_MOD_ALGORITHMS_MODULEDATA_H
 #define SHAREMIND_MOD_ALGORITHMS_MODULEDATA_H
 
+#include "BackgroundWorker.h"
+#include "ImplicitSortingNetwork.h"
+#include "ModuleConfiguration.h"
+#include "NetworkStore.h"
+#include "PermutationNetwork.h"
 #include "SortingNetworkGenerator.h"
 #include "TopKSortingNetworkGenerator.h"
 
 
 struct __attribute__ ((visibility("internal"))) ModuleData {
-    SortingNetworkGenerator<SortingNetwork> sortingNetworkGenerator;
+
+    ModuleData(ModuleConfiguration const & configuration)
+        : networkStore(configuration.networkCacheDirectory())
+        , networkCacheBudget(configuration.networkCacheSize())
+        , oddEvenMergeSortingNetworkGenerator(
+              networkCacheBudget,
+              networkStore,
+              loadBakedNetworks<OddEvenMergeSortingNetwork>(
+                  [](std::size_t const elements) {
+                      return bakedSortingNetwork(
+                                  SORTING_NETWORK_ODD_EVEN_MERGE_SORT,
+                                  elements);
+                  }))
+        , bitonicSortingNetworkGenerator(
+              networkCacheBudget,
+              networkStore,
+              loadBakedNetworks<BitonicSortingNetwork>(
+                  [](std::size_t const elements) {
+                      return bakedSortingNetwork(
+                                  SORTING_NETWORK_BITONIC_MERGE_SORT,
+                                  elements);
+                  }))
+        , pairwiseSortingNetworkGenerator(
+              networkCacheBudget,
+              networkStore,
+              loadBakedNetworks<PairwiseSortingNetwork>(
+                  [](std::size_t const elements) {
+                      return bakedSortingNetwork(
+                                  SORTING_NETWORK_PAIRWISE_SORT,
+                                  elements);
+                  }))
+        , mergingNetworkGenerator(
+              networkCacheBudget,
+              networkStore,
+              loadBakedNetworks<MergingNetwork>(&bakedMergingNetwork))
+        , unequalMergingNetworkGenerator(networkCacheBudget, networkStore)
+        , multiwayMergingNetworkGenerator(networkCacheBudget, networkStore)
+        , topKSortingNetworkGenerator(
+              networkCacheBudget,
+              networkStore,
+              TopKSortingNetworkGenerator::loadBakedNetworks())
+        , permutationNetworkGenerator(networkCacheBudget, networkStore)
+        , selectionNetworkGenerator(networkCacheBudget, networkStore)
+    {
+        // Generate the configured networks in the background:
+        for (auto const elements : configuration.prewarmSortingNetworks())
+            backgroundWorker.enqueue(
+                    [this, elements]() {
+                        oddEvenMergeSortingNetworkGenerator
+                                .getCachedOrGenerateAndCacheNetwork(elements);
+                    });
+        for (auto const elements : configuration.prewarmMergingNetworks())
+            backgroundWorker.enqueue(
+                    [this, elements]() {
+                        mergingNetworkGenerator
+                                .getCachedOrGenerateAndCacheNetwork(elements);
+                    });
+        for (auto const & nk : configuration.prewarmTopKSortingNetworks())
+            backgroundWorker.enqueue(
+                    [this, nk]() {
+                        topKSortingNetworkGenerator
+                                .getCachedOrGenerateAndCacheNetwork(nk.first,
+                                                                    nk.second);
+                    });
+    }
+
+    NetworkStore const networkStore;
+    /* Shared by all generators, so that NetworkCacheSize limits the module as
+       a whole: */
+    NetworkCacheBudget networkCacheBudget;
+    /* The default generator, used by the syscalls without an algorithm
+       argument and by PrewarmSortingNetworks: */
+    SortingNetworkGenerator<OddEvenMergeSortingNetwork>
+            oddEvenMergeSortingNetworkGenerator;
+    SortingNetworkGenerator<BitonicSortingNetwork>
+            bitonicSortingNetworkGenerator;
+    SortingNetworkGenerator<PairwiseSortingNetwork>
+            pairwiseSortingNetworkGenerator;
+    ImplicitSortingNetworkGenerator<ImplicitBitonicSortingNetwork>
+            implicitBitonicSortingNetworkGenerator;
+    ImplicitSortingNetworkGenerator<ImplicitOddEvenMergeSortingNetwork>
+            implicitOddEvenMergeSortingNetworkGenerator;
     SortingNetworkGenerator<MergingNetwork> mergingNetworkGenerator;
+    SortingNetworkGenerator<UnequalMergingNetwork, UnequalMergingNetwork::Runs>
+            unequalMergingNetworkGenerator;
+    SortingNetworkGenerator<MultiwayMergingNetwork,
+                            MultiwayMergingNetwork::Runs>
+            multiwayMergingNetworkGenerator;
     TopKSortingNetworkGenerator topKSortingNetworkGenerator;
+    SortingNetworkGenerator<PermutationNetwork> permutationNetworkGenerator;
+    SortingNetworkGenerator<SelectionNetwork, SelectionNetwork::Ranks>
+            selectionNetworkGenerator;
+
+    /* Declared last, so that background tasks are finished before anything
+       they might use is destroyed: */
+    BackgroundWorker backgroundWorker;
 };
 
 #endif /* SHAREMIND_MOD_ALGORITHMS_MODULEDATA_H */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#include "NetworkBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+
+NetworkBuilder::NetworkBuilder(std::size_t const numInputs,
+                               bool const measureOnly)
+    : m_wireDepths(
+        [numInputs]() {
+            if (numInputs > std::numeric_limits<std::uint32_t>::max())
+                throw std::length_error("Too many network inputs!");
+            return numInputs;
+        }(),
+        0u)
+    , m_measureOnly(measureOnly)
+{}
+
+void NetworkBuilder::addComparator(std::size_t const min,
+                                   std::size_t const max)
+{
+    assert(min != max);
+    assert(min < numInputs());
+    assert(max < numInputs());
+    std::size_t const stage = std::max(m_wireDepths[min], m_wireDepths[max]);
+    if (stage == m_stageWidths.size())
+        m_stageWidths.push_back(0u);
+    ++m_stageWidths[stage];
+    if (!m_measureOnly) {
+        if (stage == m_stages.size())
+            m_stages.emplace_back();
+        m_stages[stage].emplace_back(static_cast<std::uint32_t>(min),
+                                     static_cast<std::uint32_t>(max));
+    }
+    m_wireDepths[min] = m_wireDepths[max] = stage + 1u;
+    ++m_numComparators;
+}
+
+NetworkMetrics NetworkBuilder::metrics() const noexcept {
+    NetworkMetrics r{m_stageWidths.size(), m_numComparators, 0u};
+    for (auto const width : m_stageWidths)
+        r.maxStageWidth = std::max<std::uint64_t>(r.maxStageWidth, width);
+    return r;
+}
+
+std::unique_ptr<NetworkImage const> NetworkBuilder::build() const {
+    assert(!m_measureOnly);
+    std::vector<std::uint64_t> r;
+    r.reserve(1u + m_stages.size() + 4u * m_numComparators);
+    // First, we store the number of stages
+    r.push_back(m_stages.size());
+    // Second, we store each stage separately
+    for (auto const & stage : m_stages) {
+        // For each stage, we store its size as a single number
+        r.push_back(stage.size());
+
+        // First we store the left sides of the pairs
+        for (auto const & comp : stage)
+            r.push_back(std::min(comp.first, comp.second));
+
+        // Then, we store the right sides of the pairs
+        for (auto const & comp : stage)
+            r.push_back(std::max(comp.first, comp.second));
+
+        // We also store the target positions. Minima first.
+        for (auto const & comp : stage)
+            r.push_back(comp.first);
+
+        // Maxima second.
+        for (auto const & comp : stage)
+            r.push_back(comp.second);
+    }
+    return std::make_unique<NetworkImage const>(std::move(r));
+}
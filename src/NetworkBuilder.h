@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_NETWORKBUILDER_H
+#define SHAREMIND_MOD_ALGORITHMS_NETWORKBUILDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "NetworkMetrics.h"
+#include "NetworkStore.h"
+
+
+/**
+  \brief Builds a network in the serialized format of SerializableNetwork from
+         comparators given in the order they are to be applied.
+  \details Every comparator is placed into the earliest stage after all the
+           stages already using either of its wires, so the depth of the built
+           network is the length of the longest chain of dependent
+           comparators.
+
+           A builder which only measures a network keeps just the depths of
+           the wires and the widths of the stages, so it needs memory linear
+           in the number of inputs and the depth but not in the number of
+           comparators.
+*/
+class __attribute__ ((visibility("internal"))) NetworkBuilder {
+
+public: /* Methods: */
+
+    /**
+      \param[in] measureOnly Whether to only measure the network instead of
+                             building it, in which case build() may not be
+                             called.
+      \throws std::length_error if numInputs does not fit 32 bits.
+    */
+    explicit NetworkBuilder(std::size_t numInputs, bool measureOnly = false);
+
+    /**
+      \brief Adds a comparator which places the minimum of the values on the
+             two given wires onto the first wire and the maximum onto the
+             second wire.
+    */
+    void addComparator(std::size_t min, std::size_t max);
+
+    std::size_t numInputs() const noexcept { return m_wireDepths.size(); }
+    std::size_t numStages() const noexcept { return m_stageWidths.size(); }
+    std::size_t numComparators() const noexcept { return m_numComparators; }
+
+    NetworkMetrics metrics() const noexcept;
+
+    /** \pre The builder does not only measure the network. */
+    std::unique_ptr<NetworkImage const> build() const;
+
+private: /* Fields: */
+
+    /** For every wire, the number of stages up to its last comparator. */
+    std::vector<std::size_t> m_wireDepths;
+    std::vector<std::size_t> m_stageWidths;
+    bool const m_measureOnly;
+    /** Wires are stored in 32 bits, which halves the memory needed. */
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t> > >
+            m_stages;
+    std::size_t m_numComparators = 0u;
+
+}; /* class NetworkBuilder { */
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_NETWORKBUILDER_H */
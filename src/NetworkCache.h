@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_NETWORKCACHE_H
+#define SHAREMIND_MOD_ALGORITHMS_NETWORKCACHE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+/**
+  \brief A capacity in bytes shared by the NetworkCaches of a module.
+  \details The caches charge the memory of their networks to the budget, and
+           take the times of the uses of their networks from its clock.
+           Whenever the charged memory exceeds the capacity, the least
+           recently used networks of all caches are evicted, so the capacity
+           is divided between the kinds of networks by how recently they are
+           used.
+*/
+class __attribute__ ((visibility("internal"))) NetworkCacheBudget {
+
+public: /* Types: */
+
+    /** \brief A cache whose networks the budget may evict. */
+    class Evictable {
+
+    public: /* Methods: */
+
+        virtual ~Evictable() noexcept {}
+
+        /**
+          \brief Finds the least recently used network other than keep which
+                 can be evicted.
+          \param[in] keep The network which may not be evicted, if any.
+          \returns whether there is such a network.
+        */
+        virtual bool leastRecentlyUsed(void const * keep,
+                                       std::uint64_t & lastUse) const = 0;
+
+        /** \brief Evicts the least recently used network other than keep. */
+        virtual void evictLeastRecentlyUsed(void const * keep) = 0;
+
+    };
+
+public: /* Methods: */
+
+    /** \param[in] capacity The capacity in bytes, or zero for no limit. */
+    explicit NetworkCacheBudget(std::size_t const capacity = 0u) noexcept
+        : m_capacity(capacity)
+    {}
+
+    NetworkCacheBudget(NetworkCacheBudget const &) = delete;
+    NetworkCacheBudget & operator=(NetworkCacheBudget const &) = delete;
+
+    std::size_t capacity() const noexcept { return m_capacity; }
+
+    /** \returns the number of bytes charged to the budget. */
+    std::size_t chargedBytes() const noexcept { return m_chargedBytes; }
+
+    void charge(std::size_t const bytes) noexcept { m_chargedBytes += bytes; }
+    void release(std::size_t const bytes) noexcept { m_chargedBytes -= bytes; }
+
+    /** \returns the time of a use of a network. */
+    std::uint64_t tick() noexcept { return ++m_clock; }
+
+    void addCache(Evictable & cache) {
+        std::lock_guard<std::mutex> const guard(m_mutex);
+        m_caches.push_back(&cache);
+    }
+
+    void removeCache(Evictable & cache) noexcept {
+        std::lock_guard<std::mutex> const guard(m_mutex);
+        for (auto it(m_caches.begin()); it != m_caches.end(); ++it) {
+            if (*it == &cache) {
+                m_caches.erase(it);
+                return;
+            }
+        }
+    }
+
+    /**
+      \brief Evicts the least recently used networks of all caches other than
+             keep until the charged memory fits the capacity.
+      \pre The calling thread does not hold the lock of any cache.
+    */
+    void evictOverCapacity(void const * const keep = nullptr) {
+        if (!m_capacity)
+            return;
+        std::lock_guard<std::mutex> const guard(m_mutex);
+        while (m_chargedBytes > m_capacity) {
+            Evictable * victim = nullptr;
+            std::uint64_t victimLastUse = 0u;
+            for (auto * const cache : m_caches) {
+                std::uint64_t lastUse;
+                if (cache->leastRecentlyUsed(keep, lastUse)
+                    && (!victim || lastUse < victimLastUse))
+                {
+                    victim = cache;
+                    victimLastUse = lastUse;
+                }
+            }
+            if (!victim)
+                return;
+            victim->evictLeastRecentlyUsed(keep);
+        }
+    }
+
+private: /* Fields: */
+
+    std::size_t const m_capacity;
+    std::atomic<std::size_t> m_chargedBytes{0u};
+    std::atomic<std::uint64_t> m_clock{0u};
+
+    /** Serializes evictions, and protects m_caches. */
+    std::mutex m_mutex;
+    std::vector<Evictable *> m_caches;
+
+}; /* class NetworkCacheBudget { */
+
+
+/**
+  \brief A cache of generated networks which does not hold any lock while a
+         network is being generated.
+  \details Lookups of networks which are already cached only take a shared
+           lock. Networks for distinct keys are generated concurrently by the
+           threads requesting them, and concurrent requests for a network
+           which is still being generated wait for that generation to finish
+           instead of generating it again.
+
+           The memoryUsage() of the cached networks is charged to a
+           NetworkCacheBudget, which evicts least recently used networks of
+           any of its caches whenever its capacity is exceeded. The network
+           just cached is not evicted for this, even if it alone exceeds the
+           capacity, so that it is found by the calls following the one
+           generating it. Evicted networks stay alive for as long as the
+           pointers returned for them are in use.
+*/
+template <typename Key, typename T>
+class __attribute__ ((visibility("internal"))) NetworkCache
+        : private NetworkCacheBudget::Evictable
+{
+
+public: /* Types: */
+
+    using Pointer = std::shared_ptr<T const>;
+
+    struct Statistics {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::uint64_t residentBytes;
+        std::uint64_t cachedNetworks;
+    };
+
+private: /* Types: */
+
+    struct Entry {
+
+        Entry(std::shared_future<Pointer> future_, std::uint64_t const lastUse_)
+            : future(std::move(future_))
+            , lastUse(lastUse_)
+        {}
+
+        std::shared_future<Pointer> future;
+        bool generated = false;
+        std::size_t size = 0u;
+        std::atomic<std::uint64_t> lastUse;
+
+    };
+
+    using Entries = std::map<Key, Entry>;
+
+public: /* Methods: */
+
+    explicit NetworkCache(NetworkCacheBudget & budget)
+        : m_budget(budget)
+    { m_budget.addCache(*this); }
+
+    ~NetworkCache() noexcept override {
+        m_budget.removeCache(*this);
+        m_budget.release(m_residentBytes);
+    }
+
+    /**
+      \brief Returns the cached network for the given key, generating and
+             caching it using generate(key) if needed.
+      \details If the generation fails, the exception is propagated to all
+               threads waiting for that network and nothing is cached.
+    */
+    template <typename Generate>
+    Pointer getOrGenerate(Key const & key, Generate && generate) {
+        std::shared_future<Pointer> future;
+        {
+            std::shared_lock<std::shared_timed_mutex> const lock(m_mutex);
+            auto const it(m_entries.find(key));
+            if (it != m_entries.cend()) {
+                it->second.lastUse = m_budget.tick();
+                future = it->second.future;
+            }
+        }
+        if (future.valid()) {
+            ++m_hits;
+            return future.get();
+        }
+
+        std::promise<Pointer> promise;
+        {
+            std::lock_guard<std::shared_timed_mutex> const lock(m_mutex);
+            auto const rv(m_entries.emplace(
+                              std::piecewise_construct,
+                              std::forward_as_tuple(key),
+                              std::forward_as_tuple(
+                                  promise.get_future().share(),
+                                  m_budget.tick())));
+            if (!rv.second) {
+                rv.first->second.lastUse = m_budget.tick();
+                future = rv.first->second.future;
+            }
+        }
+        if (future.valid()) {
+            ++m_hits;
+            return future.get();
+        }
+
+        // We are responsible for generating the network:
+        ++m_misses;
+        Pointer r;
+        try {
+            r = generate(key);
+        } catch (...) {
+            {
+                std::lock_guard<std::shared_timed_mutex> const lock(m_mutex);
+                m_entries.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        std::size_t const size = r->memoryUsage();
+        Entry const * entry;
+        {
+            std::lock_guard<std::shared_timed_mutex> const lock(m_mutex);
+            auto const it(m_entries.find(key));
+            assert(it != m_entries.end());
+            it->second.generated = true;
+            it->second.size = size;
+            m_residentBytes += size;
+            m_budget.charge(size);
+            entry = &it->second;
+        }
+        promise.set_value(r);
+        m_budget.evictOverCapacity(entry);
+        return r;
+    }
+
+    /**
+      \brief Returns the cached network for the given key, or nullptr if it is
+             not cached.
+      \details If the network is still being generated, waits for it.
+    */
+    Pointer find(Key const & key) {
+        std::shared_future<Pointer> future;
+        {
+            std::shared_lock<std::shared_timed_mutex> const lock(m_mutex);
+            auto const it(m_entries.find(key));
+            if (it == m_entries.cend())
+                return nullptr;
+            it->second.lastUse = m_budget.tick();
+            future = it->second.future;
+        }
+        ++m_hits;
+        return future.get();
+    }
+
+    NetworkCacheBudget & budget() const noexcept { return m_budget; }
+
+    /** \returns the number of bytes used by the cached networks. */
+    std::size_t residentBytes() const {
+        std::shared_lock<std::shared_timed_mutex> const lock(m_mutex);
+        return m_residentBytes;
+    }
+
+    Statistics statistics() const {
+        std::shared_lock<std::shared_timed_mutex> const lock(m_mutex);
+        Statistics r;
+        r.hits = m_hits;
+        r.misses = m_misses;
+        r.evictions = m_evictions;
+        r.residentBytes = m_residentBytes;
+        r.cachedNetworks = 0u;
+        for (auto const & vp : m_entries)
+            if (vp.second.generated)
+                ++r.cachedNetworks;
+        return r;
+    }
+
+private: /* Methods: */
+
+    /** \returns the least recently used generated entry other than keep. */
+    typename Entries::const_iterator leastRecentlyUsedEntry(
+            void const * const keep) const noexcept
+    {
+        auto victim(m_entries.cend());
+        for (auto it(m_entries.cbegin()); it != m_entries.cend(); ++it) {
+            // Networks still being generated can not be evicted:
+            if (it->second.generated
+                && &it->second != keep
+                && (victim == m_entries.cend()
+                    || it->second.lastUse < victim->second.lastUse))
+                victim = it;
+        }
+        return victim;
+    }
+
+    bool leastRecentlyUsed(void const * const keep,
+                           std::uint64_t & lastUse) const override
+    {
+        std::shared_lock<std::shared_timed_mutex> const lock(m_mutex);
+        auto const victim(leastRecentlyUsedEntry(keep));
+        if (victim == m_entries.cend())
+            return false;
+        lastUse = victim->second.lastUse;
+        return true;
+    }
+
+    void evictLeastRecentlyUsed(void const * const keep) override {
+        std::lock_guard<std::shared_timed_mutex> const lock(m_mutex);
+        auto const victim(leastRecentlyUsedEntry(keep));
+        if (victim == m_entries.cend())
+            return;
+        m_residentBytes -= victim->second.size;
+        m_budget.release(victim->second.size);
+        m_entries.erase(victim);
+        ++m_evictions;
+    }
+
+private: /* Fields: */
+
+    NetworkCacheBudget & m_budget;
+
+    mutable std::shared_timed_mutex m_mutex;
+    Entries m_entries;
+
+    std::atomic<std::uint64_t> m_hits{0u};
+    std::atomic<std::uint64_t> m_misses{0u};
+    std::uint64_t m_evictions = 0u;
+    std::size_t m_residentBytes = 0u;
+
+}; /* class NetworkCache { */
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_NETWORKCACHE_H */
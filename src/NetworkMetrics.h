@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_NETWORKMETRICS_H
+#define SHAREMIND_MOD_ALGORITHMS_NETWORKMETRICS_H
+
+#include <cstdint>
+
+
+/**
+  \brief The depth, the number of comparators and the number of comparators
+         in the widest stage of a network.
+*/
+struct NetworkMetrics {
+    std::uint64_t depth;
+    std::uint64_t comparators;
+    std::uint64_t maxStageWidth;
+};
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_NETWORKMETRICS_H */
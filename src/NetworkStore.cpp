@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#include "NetworkStore.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+
+namespace /* anonymous */ {
+
+/* Every file starts with a header of five words: the magic number "SMALGNET",
+   the format version, the length of the name of the network in bytes, the
+   number of words in the network and their checksum. The header is followed by
+   the name, padded with zeroes to whole words, and the network. Bump the
+   format version whenever the layout of the files changes. */
+constexpr std::uint64_t const fileMagic = 0x54454e474c414d53u;
+constexpr std::uint64_t const fileFormatVersion = 2u;
+constexpr std::size_t const headerWords = 5u;
+
+/* Names longer than this are hashed into file names of a fixed length, which
+   keep a prefix of the name for readability: */
+constexpr std::size_t const maxFileNameLength = 64u;
+constexpr std::size_t const fileNamePrefixLength = 40u;
+
+std::uint64_t checksum(std::uint64_t const * data, std::size_t size) noexcept {
+    // FNV-1a, applied to whole words:
+    std::uint64_t r = 0xcbf29ce484222325u;
+    for (; size; --size, ++data)
+        r = (r ^ *data) * 0x100000001b3u;
+    return r;
+}
+
+std::uint64_t nameHash(std::string const & name) noexcept {
+    // FNV-1a:
+    std::uint64_t r = 0xcbf29ce484222325u;
+    for (unsigned char const c : name)
+        r = (r ^ c) * 0x100000001b3u;
+    return r;
+}
+
+std::string fileName(std::string const & name) {
+    if (name.size() <= maxFileNameLength)
+        return name;
+    char hash[17u];
+    std::snprintf(hash, sizeof(hash), "%016" PRIx64, nameHash(name));
+    return name.substr(0u, fileNamePrefixLength) + '-' + hash;
+}
+
+/** \returns the name padded with zeroes to whole words. */
+std::vector<std::uint64_t> nameWords(std::string const & name) {
+    std::vector<std::uint64_t> r(
+                (name.size() + sizeof(std::uint64_t) - 1u)
+                / sizeof(std::uint64_t),
+                0u);
+    if (!name.empty())
+        std::memcpy(r.data(), name.data(), name.size());
+    return r;
+}
+
+bool writeAll(int const fd, void const * data, std::size_t size) noexcept {
+    char const * ptr = static_cast<char const *>(data);
+    while (size) {
+        auto const r = ::write(fd, ptr, size);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        ptr += r;
+        size -= static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+/**
+  \returns whether the file is a regular file or a directory of the given
+           type, which is owned by the user of the server and writable by
+           nobody else, so that no other user can modify or replace networks.
+*/
+bool isPrivateToServer(struct ::stat const & st, mode_t const type) noexcept {
+    return (st.st_mode & S_IFMT) == type
+           && st.st_uid == ::geteuid()
+           && !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+/**
+  \brief Creates the store directory if it does not exist.
+  \returns the directory, or an empty string to disable the store if the
+           directory is not private to the server.
+*/
+std::string privateDirectory(std::string directory) {
+    if (directory.empty())
+        return directory;
+    ::mkdir(directory.c_str(), 0700); // Might already exist
+    struct ::stat st;
+    if (::stat(directory.c_str(), &st) != 0
+        || !isPrivateToServer(st, S_IFDIR))
+        return std::string();
+    return directory;
+}
+
+} /* namespace anonymous { */
+
+
+NetworkImage::NetworkImage(std::vector<std::uint64_t> words) noexcept
+    : m_words(std::move(words))
+    , m_data(m_words.data())
+    , m_size(m_words.size())
+{}
+
+NetworkImage::NetworkImage(std::uint64_t const * const data,
+                           std::size_t const size) noexcept
+    : NetworkImage(nullptr, 0u, data, size)
+{}
+
+NetworkImage::NetworkImage(void * const mapping,
+                           std::size_t const mappingSize,
+                           std::uint64_t const * const data,
+                           std::size_t const size) noexcept
+    : m_mapping(mapping)
+    , m_mappingSize(mappingSize)
+    , m_data(data)
+    , m_size(size)
+{}
+
+NetworkImage::~NetworkImage() noexcept {
+    if (m_mapping)
+        ::munmap(m_mapping, m_mappingSize);
+}
+
+std::size_t NetworkImage::memoryUsage() const noexcept {
+    return sizeof(*this)
+           + m_words.capacity() * sizeof(std::uint64_t)
+           + m_mappingSize;
+}
+
+NetworkStore::NetworkStore(std::string directory)
+    : m_directory(privateDirectory(std::move(directory)))
+{}
+
+std::unique_ptr<NetworkImage const> NetworkStore::load(
+        std::string const & name) const
+{
+    if (!enabled())
+        return nullptr;
+
+    /* Different names might be hashed into the same file name, so the name in
+       the file is checked too: */
+    auto const expectedName(nameWords(name));
+    std::string const path(m_directory + '/' + fileName(name));
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0)
+        return nullptr;
+
+    /* Only files which no other user can truncate or modify are mapped, as
+       changes after the checksum would be seen through the mapping: */
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0
+        || !isPrivateToServer(st, S_IFREG)
+        || st.st_size < static_cast<off_t>(headerWords * sizeof(std::uint64_t))
+        || st.st_size % sizeof(std::uint64_t) != 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::size_t const mappingSize = static_cast<std::size_t>(st.st_size);
+    void * const mapping =
+            ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    std::uint64_t const * const words =
+            static_cast<std::uint64_t const *>(mapping);
+    std::size_t const nameAndDataSize =
+            mappingSize / sizeof(std::uint64_t) - headerWords;
+    std::uint64_t const * const data =
+            words + headerWords + expectedName.size();
+    if (words[0u] != fileMagic
+        || words[1u] != fileFormatVersion
+        || words[2u] != name.size()
+        || nameAndDataSize < expectedName.size()
+        || !std::equal(expectedName.cbegin(),
+                       expectedName.cend(),
+                       words + headerWords)
+        || words[3u] != nameAndDataSize - expectedName.size()
+        || words[4u] != checksum(data, words[3u]))
+    {
+        ::munmap(mapping, mappingSize);
+        return nullptr;
+    }
+
+    try {
+        return std::unique_ptr<NetworkImage const>(
+                    new NetworkImage(mapping,
+                                     mappingSize,
+                                     data,
+                                     static_cast<std::size_t>(words[3u])));
+    } catch (...) {
+        ::munmap(mapping, mappingSize);
+        throw;
+    }
+}
+
+void NetworkStore::store(std::string const & name,
+                         std::uint64_t const * const data,
+                         std::size_t const size) const
+{
+    assert(data || !size);
+    if (!enabled())
+        return;
+
+    std::string const path(m_directory + '/' + fileName(name));
+    std::string const tmpPath(
+                path + ".tmp." + std::to_string(::getpid()) + '.'
+                + std::to_string(
+                    std::hash<std::thread::id>()(std::this_thread::get_id())));
+    int const fd = ::open(tmpPath.c_str(),
+                          O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                          0600);
+    if (fd < 0)
+        return;
+
+    auto const paddedName(nameWords(name));
+    std::uint64_t const header[headerWords] = { fileMagic,
+                                                fileFormatVersion,
+                                                name.size(),
+                                                size,
+                                                checksum(data, size) };
+    bool const written =
+            writeAll(fd, header, sizeof(header))
+            && writeAll(fd,
+                        paddedName.data(),
+                        paddedName.size() * sizeof(std::uint64_t))
+            && writeAll(fd, data, size * sizeof(std::uint64_t));
+    if (::close(fd) != 0 || !written
+        || ::rename(tmpPath.c_str(), path.c_str()) != 0)
+        ::unlink(tmpPath.c_str());
+}
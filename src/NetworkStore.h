@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_NETWORKSTORE_H
+#define SHAREMIND_MOD_ALGORITHMS_NETWORKSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+  \brief A read-only serialized network, either held in memory, mapped from a
+         file of a NetworkStore or baked into the module.
+*/
+class __attribute__ ((visibility("internal"))) NetworkImage {
+
+    friend class NetworkStore;
+
+public: /* Methods: */
+
+    explicit NetworkImage(std::vector<std::uint64_t> words) noexcept;
+
+    /** \brief Constructs an image of static data, which is not copied. */
+    NetworkImage(std::uint64_t const * data, std::size_t size) noexcept;
+
+    NetworkImage(NetworkImage const &) = delete;
+    NetworkImage & operator=(NetworkImage const &) = delete;
+    ~NetworkImage() noexcept;
+
+    std::uint64_t const * data() const noexcept { return m_data; }
+    std::size_t size() const noexcept { return m_size; }
+
+    /** \returns the number of bytes held in memory or mapped for the image. */
+    std::size_t memoryUsage() const noexcept;
+
+private: /* Methods: */
+
+    NetworkImage(void * mapping,
+                 std::size_t mappingSize,
+                 std::uint64_t const * data,
+                 std::size_t size) noexcept;
+
+private: /* Fields: */
+
+    std::vector<std::uint64_t> const m_words;
+    void * const m_mapping = nullptr;
+    std::size_t const m_mappingSize = 0u;
+    std::uint64_t const * const m_data;
+    std::size_t const m_size;
+
+}; /* class NetworkImage { */
+
+/**
+  \brief A directory of serialized networks which persists generated networks
+         across restarts of the server.
+  \details Every network is stored in a file of its own, together with a
+           format version, its full name and a checksum of its contents.
+           Networks with long names, e.g. named after a list of run lengths,
+           are stored in files named after a hash of the name instead, so
+           that names of any length are within the limits of the file system.
+           Files which fail validation are ignored. Networks are written to
+           temporary files and renamed into place, so concurrent server
+           processes may share a directory. The directory and the files are
+           private to the user of the server: the store is disabled if the
+           directory is owned or writable by another user, and such files are
+           ignored. All I/O errors are ignored, a failure to load or to store
+           a network only means that it is generated again.
+*/
+class __attribute__ ((visibility("internal"))) NetworkStore {
+
+public: /* Methods: */
+
+    /** \param[in] directory The directory to use, or empty to disable. */
+    explicit NetworkStore(std::string directory);
+
+    bool enabled() const noexcept { return !m_directory.empty(); }
+
+    /**
+      \returns the mapped network with the given name, or nullptr if the store
+               is disabled or it contains no valid network of that name.
+    */
+    std::unique_ptr<NetworkImage const> load(std::string const & name) const;
+
+    /** \brief Stores the given serialized network under the given name. */
+    void store(std::string const & name,
+               std::uint64_t const * data,
+               std::size_t size) const;
+
+private: /* Fields: */
+
+    std::string const m_directory;
+
+}; /* class NetworkStore { */
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_NETWORKSTORE_H */
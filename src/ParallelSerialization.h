@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_PARALLELSERIALIZATION_H
+#define SHAREMIND_MOD_ALGORITHMS_PARALLELSERIALIZATION_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+/**
+  Networks with serializations of fewer words are serialized by the calling
+  thread with ordinary stores, which is faster for networks which fit into
+  the caches.
+*/
+constexpr std::size_t parallelSerializationThreshold = 1u << 22u;
+
+/** The least number of words worth serializing in a separate thread. */
+constexpr std::size_t minWordsPerSerializationThread = 1u << 20u;
+
+/** \returns the number of threads to serialize the given number of words. */
+inline std::size_t serializationThreads(std::size_t const words) noexcept {
+    if (words < parallelSerializationThreshold)
+        return 1u;
+    std::size_t const hardwareThreads = std::thread::hardware_concurrency();
+    return std::max<std::size_t>(
+                1u,
+                std::min(hardwareThreads,
+                         words / minWordsPerSerializationThread));
+}
+
+/**
+  \brief Calls f(i) for every i < n, dynamically distributing the calls over
+         up to numThreads threads, including the calling thread.
+  \details If threads can not be started, the calls are made by the threads
+           which could be started.
+*/
+template <typename F>
+void parallelFor(std::size_t const n,
+                 std::size_t const numThreads,
+                 F const & f) noexcept
+{
+    if (!n)
+        return;
+    std::atomic<std::size_t> next{0u};
+    auto const work =
+            [&next, n, &f]() noexcept {
+                for (std::size_t i; (i = next++) < n;)
+                    f(i);
+            };
+    std::vector<std::thread> threads;
+    try {
+        threads.reserve(std::min(numThreads, n) - 1u);
+        while (threads.size() + 1u < std::min(numThreads, n))
+            threads.emplace_back(work);
+    } catch (...) {}
+    work();
+    for (auto & thread : threads)
+        thread.join();
+}
+
+/**
+  \brief Copies words with non-temporal stores where available, which do not
+         evict the network from the caches in favour of its copy.
+*/
+inline void copyWordsNonTemporal(std::uint64_t const * src,
+                                 std::size_t n,
+                                 std::uint64_t * dst) noexcept
+{
+#if defined(__SSE2__)
+    // Streaming stores need 16-byte aligned destinations:
+    for (; n && (reinterpret_cast<std::uintptr_t>(dst) & 15u); --n)
+        (*dst++) = (*src++);
+    for (; n >= 2u; n -= 2u, src += 2u, dst += 2u)
+        _mm_stream_si128(
+                reinterpret_cast<__m128i *>(dst),
+                _mm_loadu_si128(reinterpret_cast<__m128i const *>(src)));
+    if (n)
+        (*dst) = (*src);
+    _mm_sfence();
+#else
+    std::copy(src, src + n, dst);
+#endif
+}
+
+inline void copyWordsNonTemporal(std::uint64_t const * src,
+                                 std::size_t n,
+                                 std::uint32_t * dst) noexcept
+{
+#if defined(__SSE2__)
+    for (; n && (reinterpret_cast<std::uintptr_t>(dst) & 15u); --n)
+        (*dst++) = static_cast<std::uint32_t>(*src++);
+    for (; n >= 4u; n -= 4u, src += 4u, dst += 4u) {
+        // Keep the lower halves of four 64-bit words:
+        __m128i const a = _mm_shuffle_epi32(
+                    _mm_loadu_si128(reinterpret_cast<__m128i const *>(src)),
+                    _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i const b = _mm_shuffle_epi32(
+                    _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(src + 2u)),
+                    _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst),
+                         _mm_unpacklo_epi64(a, b));
+    }
+    for (; n; --n)
+        (*dst++) = static_cast<std::uint32_t>(*src++);
+    _mm_sfence();
+#else
+    std::copy(src, src + n, dst);
+#endif
+}
+
+/**
+  \brief Copies n words of a serialized network from src to dst, in parallel
+         and with non-temporal stores if there are at least
+         parallelSerializationThreshold words.
+  \details Word may be std::uint64_t, or std::uint32_t if all the words fit.
+*/
+template <typename Word>
+void copySerializedWords(std::uint64_t const * const src,
+                         std::size_t const n,
+                         Word * const dst) noexcept
+{
+    static_assert(std::is_same<Word, std::uint64_t>::value
+                  || std::is_same<Word, std::uint32_t>::value,
+                  "Only 64-bit and 32-bit words are supported!");
+    if (n < parallelSerializationThreshold) {
+        std::copy(src, src + n, dst);
+        return;
+    }
+    std::size_t const parts = serializationThreads(n);
+    parallelFor(parts,
+                parts,
+                [src, n, dst, parts](std::size_t const part) noexcept {
+                    std::size_t const begin = n / parts * part;
+                    std::size_t const end =
+                            (part + 1u == parts) ? n : n / parts * (part + 1u);
+                    copyWordsNonTemporal(src + begin, end - begin, dst + begin);
+                });
+}
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_PARALLELSERIALIZATION_H */
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#include "PermutationNetwork.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <vector>
+
+
+namespace /* anonymous */ {
+
+using Stage = std::vector<std::pair<std::size_t, std::size_t> >;
+
+/** \returns the depth of the Waksman network for n elements. */
+std::size_t waksmanDepth(std::size_t const n) noexcept {
+    if (n < 2u)
+        return 0u;
+    if (n == 2u)
+        return 1u;
+    return waksmanDepth(n - n / 2u) + 2u;
+}
+
+/**
+  \brief Calls f(stage, left, right, set) for every switch of the Waksman
+         network on the given wires, which occupies the stages starting with
+         firstStage.
+  \details The network is built recursively from a layer of input switches,
+           two subnetworks for the wires of the even and the odd positions,
+           and a layer of output switches. If the number of wires is odd, the
+           last wire bypasses both layers into the second subnetwork, and
+           otherwise the last output switch is omitted.
+
+           If permutation is not empty, set tells whether the switch is set for
+           routing the input permutation[i] to output i. Otherwise set is
+           always false. The switches are visited in the same order in both
+           cases.
+*/
+template <typename F>
+void forEachWaksmanSwitch(std::vector<std::size_t> const & wires,
+                          std::size_t const firstStage,
+                          std::vector<std::size_t> const & permutation,
+                          F & f)
+{
+    std::size_t const n = wires.size();
+    if (n < 2u)
+        return;
+    std::size_t const half = n / 2u;
+    std::size_t const paired = 2u * half;
+    bool const routing = !permutation.empty();
+    assert(!routing || permutation.size() == n);
+
+    /* Decide for every input whether it is routed through the second
+       subnetwork. The inputs of an input switch, and the inputs routed to the
+       outputs of an output switch, must go through different subnetworks. The
+       constraints form paths and even cycles, which are colored by walking
+       them: */
+    std::vector<char> second;
+    std::vector<std::size_t> subpermutations[2u];
+    if (routing) {
+        std::vector<std::size_t> inverse(n);
+        for (std::size_t i = 0u; i < n; ++i)
+            inverse[permutation[i]] = i;
+
+        enum : char { UNDECIDED = 2 };
+        second.assign(n, UNDECIDED);
+        std::vector<std::size_t> pending;
+        auto const decide =
+                [&second, &pending](std::size_t const input, char const s) {
+                    if (second[input] == UNDECIDED) {
+                        second[input] = s;
+                        pending.push_back(input);
+                    } else {
+                        assert(second[input] == s);
+                    }
+                };
+        auto const propagate = [&]() {
+            while (!pending.empty()) {
+                std::size_t const input = pending.back();
+                pending.pop_back();
+                char const other = !second[input];
+                if (input < paired)
+                    decide(input ^ 1u, other);
+                std::size_t const output = inverse[input];
+                if (output < paired)
+                    decide(permutation[output ^ 1u], other);
+            }
+        };
+
+        // The bypassing last wire, or the omitted output switch:
+        if (n % 2u) {
+            decide(n - 1u, true);
+        } else {
+            decide(permutation[n - 1u], true);
+        }
+        propagate();
+        for (std::size_t i = 0u; i < n; ++i) {
+            if (second[i] == UNDECIDED) {
+                decide(i, false);
+                propagate();
+            }
+        }
+
+        // Input i enters its subnetwork at position i / 2 in either case:
+        subpermutations[0u].resize(half);
+        subpermutations[1u].resize(n - half);
+        for (std::size_t i = 0u; i < n; ++i)
+            subpermutations[static_cast<std::size_t>(
+                                 second[permutation[i]])][i / 2u] =
+                    permutation[i] / 2u;
+    }
+
+    // The input switches:
+    for (std::size_t i = 0u; i < half; ++i)
+        f(firstStage, wires[2u * i], wires[2u * i + 1u],
+          routing && second[2u * i]);
+
+    // The subnetworks:
+    {
+        std::vector<std::size_t> subwires;
+        subwires.reserve(n - half);
+        for (std::size_t i = 0u; i < paired; i += 2u)
+            subwires.push_back(wires[i]);
+        forEachWaksmanSwitch(subwires,
+                             firstStage + 1u,
+                             subpermutations[0u],
+                             f);
+        subwires.clear();
+        for (std::size_t i = 1u; i < n; i += 2u)
+            subwires.push_back(wires[i]);
+        if (n % 2u)
+            subwires.push_back(wires[n - 1u]);
+        forEachWaksmanSwitch(subwires,
+                             firstStage + 1u,
+                             subpermutations[1u],
+                             f);
+    }
+
+    // The output switches:
+    std::size_t const lastStage = firstStage + waksmanDepth(n) - 1u;
+    std::size_t const outputSwitches = (n % 2u) ? half : half - 1u;
+    for (std::size_t i = 0u; i < outputSwitches; ++i)
+        f(lastStage, wires[2u * i], wires[2u * i + 1u],
+          routing && second[permutation[2u * i]]);
+}
+
+/**
+  \brief Computes the numbers of switches in the stages of the Waksman network
+         for n elements, following the recursion of forEachWaksmanSwitch().
+  \param[in,out] widths The memoized results for the distinct sizes of the
+                        subnetworks, of which there are at most two on each
+                        level of the recursion.
+*/
+std::vector<std::size_t> const & waksmanStageWidths(
+        std::size_t const n,
+        std::map<std::size_t, std::vector<std::size_t> > & widths)
+{
+    auto const it(widths.find(n));
+    if (it != widths.cend())
+        return it->second;
+
+    std::vector<std::size_t> r(waksmanDepth(n), 0u);
+    if (n >= 2u) {
+        std::size_t const half = n / 2u;
+        r.front() += half;
+        for (std::size_t const size : {half, n - half}) {
+            auto const & sub = waksmanStageWidths(size, widths);
+            for (std::size_t s = 0u; s < sub.size(); ++s)
+                r[s + 1u] += sub[s];
+        }
+        r.back() += (n % 2u) ? half : half - 1u;
+    }
+    return widths.emplace(n, std::move(r)).first->second;
+}
+
+std::vector<std::size_t> identityWires(std::size_t const n) {
+    std::vector<std::size_t> r(n);
+    for (std::size_t i = 0u; i < n; ++i)
+        r[i] = i;
+    return r;
+}
+
+std::unique_ptr<NetworkImage const> generateWaksmanNetwork(
+        std::size_t const elements)
+{
+    std::vector<Stage> stages(waksmanDepth(elements));
+    auto const addSwitch = [&stages](std::size_t const stage,
+                                     std::size_t const left,
+                                     std::size_t const right,
+                                     bool)
+                           { stages[stage].emplace_back(left, right); };
+    forEachWaksmanSwitch(identityWires(elements),
+                         0u,
+                         std::vector<std::size_t>(),
+                         addSwitch);
+
+    /* In the layout of a sorting network, the targets of the minima and the
+       maxima of a stage only repeat its left and right wires: */
+    std::size_t size = 1u;
+    for (auto const & stage : stages)
+        size += 1u + 4u * stage.size();
+    std::vector<std::uint64_t> r;
+    r.reserve(size);
+    r.push_back(stages.size());
+    for (auto const & stage : stages) {
+        r.push_back(stage.size());
+        for (std::size_t copy = 0u; copy < 2u; ++copy) {
+            for (auto const & s : stage)
+                r.push_back(s.first);
+            for (auto const & s : stage)
+                r.push_back(s.second);
+        }
+    }
+    assert(r.size() == size);
+    return std::make_unique<NetworkImage const>(std::move(r));
+}
+
+} // anonymous namespace
+
+PermutationNetwork::PermutationNetwork(std::size_t const elements)
+    : SerializableNetwork(generateWaksmanNetwork(elements))
+{}
+
+NetworkMetrics PermutationNetwork::measure(std::size_t const elements) {
+    std::map<std::size_t, std::vector<std::size_t> > widths;
+    NetworkMetrics r{waksmanDepth(elements), 0u, 0u};
+    for (auto const width : waksmanStageWidths(elements, widths)) {
+        r.comparators += width;
+        r.maxStageWidth = std::max<std::uint64_t>(r.maxStageWidth, width);
+    }
+    return r;
+}
+
+void PermutationNetwork::switchSettings(std::uint64_t const * const permutation,
+                                        std::uint64_t * const settings) const
+{
+    assert(permutation);
+
+    // The index of the next switch of each stage in the serialized order:
+    std::vector<std::size_t> next(numStages());
+    std::size_t const n = elements();
+    {
+        auto const * const data = image().data();
+        std::size_t offset = 1u;
+        std::size_t index = 0u;
+        for (std::size_t s = 0u; s < numStages(); ++s) {
+            next[s] = index;
+            index += data[offset];
+            offset += 1u + 4u * data[offset];
+        }
+    }
+
+    std::vector<std::size_t> const p(permutation, permutation + n);
+    auto const setSwitch = [&next, settings](std::size_t const stage,
+                                             std::size_t,
+                                             std::size_t,
+                                             bool const set)
+                           { settings[next[stage]++] = set ? 1u : 0u; };
+    forEachWaksmanSwitch(identityWires(n), 0u, p, setSwitch);
+}
+
+bool PermutationNetwork::isPermutation(std::uint64_t const * const permutation,
+                                       std::size_t const n)
+{
+    std::vector<bool> seen(n, false);
+    for (std::size_t i = 0u; i < n; ++i) {
+        if (permutation[i] >= n || seen[permutation[i]])
+            return false;
+        seen[permutation[i]] = true;
+    }
+    return true;
+}
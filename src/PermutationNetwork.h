@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_PERMUTATIONNETWORK_H
+#define SHAREMIND_MOD_ALGORITHMS_PERMUTATIONNETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include "NetworkMetrics.h"
+#include "NetworkStore.h"
+#include "SortingNetworkGenerator.h"
+
+
+/**
+  \brief A Waksman permutation network, which can apply any permutation of its
+         inputs using O(n log n) switches.
+  \details The network is serialized in the layout of a sorting network, so
+           that it is stored, cached and serialized like one. Every stage
+           lists the left and the right wires of its switches twice, as the
+           words which hold the targets of the minima and the maxima of a
+           sorting network carry no information for a switch. An evaluator
+           may ignore the repeated words.
+
+           The switches must not be evaluated like comparators, i.e. by
+           comparing the values on their inputs, as that would sort the
+           inputs instead of permuting them. An evaluator must instead take
+           the decision of every switch from the bit which switchSettings()
+           (the PermutationNetwork_switchSettings syscall) computes for it: a
+           switch exchanges the values on its left and right wires if and
+           only if its bit is set, and passes them through otherwise.
+
+           Unlike a Beneš network, the network is not restricted to powers of
+           two, and for every recursive subnetwork one output switch is
+           omitted, saving about n/2 switches.
+*/
+class __attribute__ ((visibility("internal"))) PermutationNetwork
+        : public SerializableNetwork
+{
+
+public: /* Methods: */
+
+    explicit PermutationNetwork(std::size_t elements);
+
+    PermutationNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+    {}
+
+    /** \returns the number of elements, as every wire has a switch. */
+    std::size_t elements() const noexcept
+    { return numStages() ? maxIndex() + 1u : 1u; }
+
+    std::size_t numSwitches() const noexcept { return numComparators(); }
+
+    /**
+       \brief Computes the switch settings which make the network output
+              input[permutation[i]] as its i-th output.
+       \param[in] permutation A permutation of the indices of the inputs.
+       \param[out] settings Receives 1 for every switch which is set and 0 for
+                            every other switch, in the order in which the
+                            switches are serialized.
+       \pre isPermutation(permutation, the number of elements of the network).
+    */
+    void switchSettings(std::uint64_t const * permutation,
+                        std::uint64_t * settings) const;
+
+    /** \returns whether the given array of n indices is a permutation. */
+    static bool isPermutation(std::uint64_t const * permutation,
+                              std::size_t n);
+
+    /** \returns the metrics of the network without generating it. */
+    static NetworkMetrics measure(std::size_t elements);
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(std::size_t elements)
+    { return "PermutationNetwork-v1-" + std::to_string(elements); }
+
+}; /* class PermutationNetwork { */
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_PERMUTATIONNETWORK_H */
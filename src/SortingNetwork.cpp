@@ -20,25 +20,28 @@
 #include "SortingNetwork.h"
 
 #include <cassert>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <utility>
+#include "AllocateSerializedNetwork.h"
 #include "CatchModuleApiErrors.h"
 #include "ModuleData.h"
+#include "PermutationNetwork.h"
 #include "SortingNetworkGenerator.h"
 
 
-SHAREMIND_EXTERN_C_BEGIN
+namespace /* anonymous */ {
 
-/**
- * Mandatory argument: uint64 size of array to sort
- * Return value: the size of the sorting network.
- */
-SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serializedSize,
-                                 args, num_args, refs, crefs,
-                                 returnValue, c)
+template <typename Generator>
+SharemindModuleApi0x1Error networkSerializedSize(
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
 {
-    assert(c);
-    assert(c->moduleHandle);
-
     static_assert(std::numeric_limits<size_t>::max()
                   == std::numeric_limits<uint64_t>::max(),
                   "std::numeric_limits<size_t>::max() "
@@ -51,10 +54,6 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serializedSize,
     if (elementCount < 1)
         return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
-    SortingNetworkGenerator<SortingNetwork> & generator =
-            static_cast<ModuleData *>(c->moduleHandle)
-                ->sortingNetworkGenerator;
-
     try {
         const auto r =
                 generator.getCachedOrGenerateAndCacheNetwork(elementCount);
@@ -69,17 +68,15 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serializedSize,
     return SHAREMIND_MODULE_API_0x1_OK;
 }
 
-/**
- * Mandatory ref argument: uint64 size of array to sort
- * No return value.
- */
-SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serialize,
-                                 args, num_args, refs, crefs,
-                                 returnValue, c)
+template <typename Generator>
+SharemindModuleApi0x1Error networkSerialize(
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
 {
-    assert(c);
-    assert(c->moduleHandle);
-
     if (num_args != 1u || crefs || !refs
         || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
         || returnValue)
@@ -100,11 +97,6 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serialize,
     // Note that this strips the remainder 1 byte used by SecreC:
     const size_t availableStorageSize = refs[0u].size / sizeof(uint64_t);
 
-    // Get the sorting network service
-    SortingNetworkGenerator<SortingNetwork> & generator =
-            static_cast<ModuleData *>(c->moduleHandle)
-                ->sortingNetworkGenerator;
-
     try {
         // Do we have enough storage?
         const auto r =
@@ -122,21 +114,15 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serialize,
     return SHAREMIND_MODULE_API_0x1_OK;
 }
 
-/**
- * Mandatory argument: uint64 size of array to sort
- * Return value: the size of the merging network.
- */
-SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serializedSize,
-                                 args, num_args, refs, crefs,
-                                 returnValue, c)
+template <typename Generator>
+SharemindModuleApi0x1Error networkNumStages(
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
 {
-    assert(c);
-    assert(c->moduleHandle);
-
-    static_assert(std::numeric_limits<size_t>::max()
-                  == std::numeric_limits<uint64_t>::max(),
-                  "std::numeric_limits<size_t>::max() "
-                  "== std::numeric_limits<uint64_t>::max()");
     if (num_args != 1u || crefs || refs || !returnValue)
         return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
@@ -145,10 +131,6 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serializedSize,
     if (elementCount < 1)
         return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
-    SortingNetworkGenerator<MergingNetwork> & generator =
-            static_cast<ModuleData *>(c->moduleHandle)
-                ->mergingNetworkGenerator;
-
     try {
         const auto r =
                 generator.getCachedOrGenerateAndCacheNetwork(elementCount);
@@ -156,61 +138,157 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serializedSize,
             /// \bug This might actually be OOM or invalid argument
             return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
         }
-        returnValue->uint64[0u] = r->serializedSize();
+        returnValue->uint64[0u] = r->numStages();
     } catch (...) {
         return catchModuleApiErrors();
     }
     return SHAREMIND_MODULE_API_0x1_OK;
 }
 
-/**
- * Mandatory ref argument: uint64 size of array to sort
- * No return value.
- *
- * NOTE that this returns a merging network not a merge sort
- * network. It expects an input where two halves have already been
- * sorted and it will merge the halves.
- */
-SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serialize,
-                                 args, num_args, refs, crefs,
-                                 returnValue, c)
+template <typename Generator>
+SharemindModuleApi0x1Error networkSerializedStagesSize(
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
 {
-    assert(c);
-    assert(c->moduleHandle);
+    if (num_args != 3u || crefs || refs || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
-    if (num_args != 1u || crefs || !refs
-        || (assert(refs[0u].pData), refs[1u].pData) || returnValue)
+    const uint64_t elementCount = args[0u].uint64[0u];
+    const uint64_t firstStage = args[1u].uint64[0u];
+    const uint64_t lastStage = args[2u].uint64[0u];
+
+    if (elementCount < 1 || firstStage > lastStage)
         return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
+    try {
+        const auto r =
+                generator.getCachedOrGenerateAndCacheNetwork(elementCount);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        if (lastStage > r->numStages())
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        returnValue->uint64[0u] =
+                r->serializedStagesSize(firstStage, lastStage);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+template <typename Generator>
+SharemindModuleApi0x1Error networkSerializeStages(
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    if (num_args != 3u || crefs || !refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
-    // Get the inputs
-    static_assert(std::numeric_limits<size_t>::max()
-                  >= std::numeric_limits<uint64_t>::max(),
-                  "std::numeric_limits<size_t>::max() "
-                  ">= std::numeric_limits<uint64_t>::max()");
     const size_t elementCount = args[0u].uint64[0u];
+    const uint64_t firstStage = args[1u].uint64[0u];
+    const uint64_t lastStage = args[2u].uint64[0u];
     uint64_t * const arrayStart = static_cast<uint64_t *>(refs[0u].pData);
 
-    if (elementCount < 1)
+    if (elementCount < 1 || firstStage > lastStage)
         return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
     // Note that this strips the remainder 1 byte used by SecreC:
     const size_t availableStorageSize = refs[0u].size / sizeof(uint64_t);
 
-    // Get the sorting network service
-    SortingNetworkGenerator<MergingNetwork> & generator =
-            static_cast<ModuleData *>(c->moduleHandle)
-                ->mergingNetworkGenerator;
+    try {
+        const auto r =
+                generator.getCachedOrGenerateAndCacheNetwork(elementCount);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        if (lastStage > r->numStages()
+            || r->serializedStagesSize(firstStage, lastStage)
+               != availableStorageSize)
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        r->serializeStages(firstStage, lastStage, arrayStart);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+template <typename Generator>
+SharemindModuleApi0x1Error networkSerializedSizeCompact(
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    if (num_args != 1u || crefs || refs || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elementCount = args[0u].uint64[0u];
+
+    if (elementCount < 1)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
     try {
-        // Do we have enough storage?
         const auto r =
                 generator.getCachedOrGenerateAndCacheNetwork(elementCount);
         if (!r) {
             /// \bug This might actually be OOM or invalid argument
             return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
         }
-        if (r->serializedSize() != availableStorageSize)
+        if (!r->fitsCompactSerialization())
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        returnValue->uint64[0u] = r->serializedSize();
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+template <typename Generator>
+SharemindModuleApi0x1Error networkSerializeCompact(
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    if (num_args != 1u || crefs || !refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const size_t elementCount = args[0u].uint64[0u];
+    uint32_t * const arrayStart = static_cast<uint32_t *>(refs[0u].pData);
+
+    if (elementCount < 1)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    const size_t availableStorageSize = refs[0u].size / sizeof(uint32_t);
+
+    try {
+        const auto r =
+                generator.getCachedOrGenerateAndCacheNetwork(elementCount);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        if (!r->fitsCompactSerialization()
+            || r->serializedSize() != availableStorageSize)
             return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
         r->serialize(arrayStart);
     } catch (...) {
@@ -219,4 +297,1452 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serialize,
     return SHAREMIND_MODULE_API_0x1_OK;
 }
 
+/**
+  \brief Serializes the network for the given number of elements into newly
+         allocated public memory in words of type Word, returning its handle.
+*/
+template <typename Word, typename Generator>
+SharemindModuleApi0x1Error networkAllocateAndSerialize(
+        SharemindModuleApi0x1SyscallContext * const c,
+        Generator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    if (num_args != 1u || crefs || refs || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elementCount = args[0u].uint64[0u];
+
+    if (elementCount < 1)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    try {
+        const auto r =
+                generator.getCachedOrGenerateAndCacheNetwork(elementCount);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        if (sizeof(Word) < sizeof(uint64_t) && !r->fitsCompactSerialization())
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        return allocateSerializedNetwork<Word>(c, *r, returnValue);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+template <typename Generator>
+SharemindModuleApi0x1Error networkCacheStatistics(
+        Generator const & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    (void) args;
+
+    if (num_args != 0u || crefs || !refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    if (refs[0u].size / sizeof(uint64_t) != 5u)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    try {
+        auto const statistics(generator.cacheStatistics());
+        uint64_t * const out = static_cast<uint64_t *>(refs[0u].pData);
+        out[0u] = statistics.hits;
+        out[1u] = statistics.misses;
+        out[2u] = statistics.evictions;
+        out[3u] = statistics.residentBytes;
+        out[4u] = statistics.cachedNetworks;
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+  \brief Writes the metrics of the network for the given key into a uint64
+         array of 3 elements: the depth, the number of comparators and the
+         number of comparators in the widest stage.
+*/
+template <typename Generator, typename Key>
+SharemindModuleApi0x1Error networkMetrics(
+        Generator & generator,
+        Key const & key,
+        SharemindModuleApi0x1Reference const * const refs)
+{
+    if (!refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData))
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    if (refs[0u].size / sizeof(uint64_t) != 3u)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    try {
+        auto const metrics(generator.networkMetrics(key));
+        uint64_t * const out = static_cast<uint64_t *>(refs[0u].pData);
+        out[0u] = metrics.depth;
+        out[1u] = metrics.comparators;
+        out[2u] = metrics.maxStageWidth;
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+  \brief Queues the generation and caching of the network for the given key
+         in the background worker of the module.
+*/
+template <typename Generator, typename Key>
+SharemindModuleApi0x1Error prefetchNetwork(
+        SharemindModuleApi0x1SyscallContext * const c,
+        Generator & generator,
+        Key key)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    try {
+        static_cast<ModuleData *>(c->moduleHandle)->backgroundWorker.enqueue(
+                [&generator, key]() {
+                    generator.getCachedOrGenerateAndCacheNetwork(key);
+                });
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+  \brief Calls f(generator, numArgs) with the generator of the sorting network
+         algorithm selected by the optional argument following the
+         numMandatoryArgs mandatory arguments.
+  \details numArgs is the number of arguments without the algorithm argument.
+           Without the algorithm argument, SORTING_NETWORK_ODD_EVEN_MERGE_SORT
+           is used, which suits any number of elements.
+*/
+template <typename F>
+SharemindModuleApi0x1Error withSortingNetworkGenerator(
+        SharemindModuleApi0x1SyscallContext * const c,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        std::size_t const numMandatoryArgs,
+        F f)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    ModuleData & moduleData = *static_cast<ModuleData *>(c->moduleHandle);
+
+    if (num_args == numMandatoryArgs)
+        return f(moduleData.oddEvenMergeSortingNetworkGenerator, num_args);
+    if (num_args != numMandatoryArgs + 1u)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    switch (args[numMandatoryArgs].uint64[0u]) {
+    case SORTING_NETWORK_BITONIC_MERGE_SORT:
+        return f(moduleData.bitonicSortingNetworkGenerator, numMandatoryArgs);
+    case SORTING_NETWORK_ODD_EVEN_MERGE_SORT:
+        return f(moduleData.oddEvenMergeSortingNetworkGenerator,
+                 numMandatoryArgs);
+    case SORTING_NETWORK_PAIRWISE_SORT:
+        return f(moduleData.pairwiseSortingNetworkGenerator,
+                 numMandatoryArgs);
+    case SORTING_NETWORK_IMPLICIT_BITONIC_MERGE_SORT:
+        return f(moduleData.implicitBitonicSortingNetworkGenerator,
+                 numMandatoryArgs);
+    case SORTING_NETWORK_IMPLICIT_ODD_EVEN_MERGE_SORT:
+        return f(moduleData.implicitOddEvenMergeSortingNetworkGenerator,
+                 numMandatoryArgs);
+    default:
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+    }
+}
+
+/**
+  \brief Reads the run lengths of a multiway merge from a uint64 array.
+  \returns false if there are no runs, a run is empty or the total length
+           overflows.
+*/
+bool readMultiwayMergeRuns(SharemindModuleApi0x1CReference const & cref,
+                           MultiwayMergingNetwork::Runs & runs)
+{
+    // Note that this strips the remainder 1 byte used by SecreC:
+    std::size_t const numRuns = cref.size / sizeof(uint64_t);
+    if (numRuns < 1u)
+        return false;
+
+    uint64_t const * const lengths = static_cast<uint64_t const *>(cref.pData);
+    uint64_t total = 0u;
+    runs.reserve(numRuns);
+    for (std::size_t i = 0u; i < numRuns; ++i) {
+        if (lengths[i] < 1u
+            || lengths[i] > std::numeric_limits<uint64_t>::max() - total)
+            return false;
+        total += lengths[i];
+        runs.push_back(lengths[i]);
+    }
+    return true;
+}
+
+/**
+  \brief Reads the ranks to select out of the given number of elements from a
+         uint64 array.
+  \returns false if there are no elements or no ranks, or if the ranks are not
+           strictly ascending or not below the number of elements.
+*/
+bool readSelectionRanks(uint64_t const elements,
+                        SharemindModuleApi0x1CReference const & cref,
+                        SelectionNetwork::Ranks & ranks)
+{
+    // Note that this strips the remainder 1 byte used by SecreC:
+    std::size_t const numRanks = cref.size / sizeof(uint64_t);
+    if (elements < 1u || numRanks < 1u)
+        return false;
+
+    uint64_t const * const values = static_cast<uint64_t const *>(cref.pData);
+    ranks.first = elements;
+    ranks.second.reserve(numRanks);
+    for (std::size_t i = 0u; i < numRanks; ++i) {
+        if (values[i] >= elements || (i > 0u && values[i] <= values[i - 1u]))
+            return false;
+        ranks.second.push_back(values[i]);
+    }
+    return true;
+}
+
+/** \brief Calls f(generator, algorithm) for every SortingNetworkAlgorithm. */
+template <typename F>
+void forEachSortingNetworkGenerator(ModuleData & moduleData, F && f) {
+    f(moduleData.bitonicSortingNetworkGenerator,
+      SORTING_NETWORK_BITONIC_MERGE_SORT);
+    f(moduleData.oddEvenMergeSortingNetworkGenerator,
+      SORTING_NETWORK_ODD_EVEN_MERGE_SORT);
+    f(moduleData.pairwiseSortingNetworkGenerator,
+      SORTING_NETWORK_PAIRWISE_SORT);
+    f(moduleData.implicitBitonicSortingNetworkGenerator,
+      SORTING_NETWORK_IMPLICIT_BITONIC_MERGE_SORT);
+    f(moduleData.implicitOddEvenMergeSortingNetworkGenerator,
+      SORTING_NETWORK_IMPLICIT_ODD_EVEN_MERGE_SORT);
+}
+
+} /* namespace anonymous { */
+
+
+SHAREMIND_EXTERN_C_BEGIN
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Return value: the size of the sorting network.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkSerializedSize(generator, args, numArgs,
+                                                 refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Mandatory ref argument: uint64 array for the sorting network.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkSerialize(generator, args, numArgs,
+                                            refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Return value: the size of the merging network.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerializedSize(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory ref argument: uint64 size of array to sort
+ * No return value.
+ *
+ * NOTE that this returns a merging network not a merge sort
+ * network. It expects an input where two halves have already been
+ * sorted and it will merge the halves.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerialize(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Return value: the number of stages in the sorting network.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_numStages,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkNumStages(generator, args, numArgs,
+                                            refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory arguments: uint64 size of array to sort, uint64 index of the first
+ * stage and uint64 index one past the last stage to serialize.
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Return value: the size of the serialized stage range.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serializedStagesSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 3u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkSerializedStagesSize(
+                                generator, args, numArgs,
+                                refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory arguments: uint64 size of array to sort, uint64 index of the first
+ * stage and uint64 index one past the last stage to serialize.
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Mandatory ref argument: uint64 array for the serialized stage range.
+ * No return value.
+ *
+ * The stage range is serialized in the same format as a whole network, i.e.
+ * starting with the number of stages in the range.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_serializeStages,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 3u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkSerializeStages(generator, args, numArgs,
+                                                  refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to merge
+ * Return value: the number of stages in the merging network.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_numStages,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkNumStages(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array to merge, uint64 index of the
+ * first stage and uint64 index one past the last stage to serialize.
+ * Return value: the size of the serialized stage range.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serializedStagesSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerializedStagesSize(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array to merge, uint64 index of the
+ * first stage and uint64 index one past the last stage to serialize.
+ * Mandatory ref argument: uint64 array for the serialized stage range.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_serializeStages,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerializeStages(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Return value: the size of the sorting network in the compact format, i.e.
+ *               the number of uint32 words needed to store it.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactSortingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkSerializedSizeCompact(
+                                generator, args, numArgs,
+                                refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Mandatory ref argument: uint32 array for the sorting network.
+ * No return value.
+ *
+ * The layout is the same as for SortingNetwork_serialize, but every number is
+ * stored as an uint32.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactSortingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkSerializeCompact(generator, args, numArgs,
+                                                   refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to merge
+ * Return value: the size of the merging network in the compact format, i.e.
+ *               the number of uint32 words needed to store it.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactMergingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerializedSizeCompact(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory argument: uint64 size of array to merge
+ * Mandatory ref argument: uint32 array for the merging network.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactMergingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerializeCompact(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+
+/**
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Mandatory ref argument: uint64 array of 5 elements which receives the number
+ * of sorting network cache hits, cache misses, evicted networks, the number of
+ * bytes used by the cached networks and the number of cached networks.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_cacheStatistics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 0u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkCacheStatistics(generator, args, numArgs,
+                                                  refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory ref argument: uint64 array of 5 elements which receives the number
+ * of merging network cache hits, cache misses, evicted networks, the number of
+ * bytes used by the cached networks and the number of cached networks.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_cacheStatistics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkCacheStatistics(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+
+/**
+ * Mandatory arguments: uint64 size of array to sort, uint64 cost of a
+ * communication round and uint64 cost of a comparison.
+ * Mandatory ref argument: uint64 array of 2 elements which receives the depth
+ * and the number of comparators of the selected network.
+ * Return value: the SortingNetworkAlgorithm whose network has the least total
+ *               cost, i.e. depth * round cost + comparators * comparison cost.
+ *
+ * The candidates are compared by metrics derived from their constructions, see
+ * SortingNetwork_metrics, so only the selected network is generated. It is
+ * cached unless it is implicit, so that it can be serialized right away by
+ * passing the returned algorithm to SortingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_selectAlgorithm,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 3u || crefs || !refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elementCount = args[0u].uint64[0u];
+    const uint64_t roundCost = args[1u].uint64[0u];
+    const uint64_t comparisonCost = args[2u].uint64[0u];
+
+    if (elementCount < 1)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    if (refs[0u].size / sizeof(uint64_t) != 2u)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    ModuleData & moduleData = *static_cast<ModuleData *>(c->moduleHandle);
+
+    try {
+        bool selected = false;
+        uint64_t selectedAlgorithm = 0u;
+        NetworkMetrics selectedMetrics{0u, 0u, 0u};
+        double selectedCost = 0.0;
+        std::function<void ()> cacheSelectedNetwork;
+
+        forEachSortingNetworkGenerator(
+            moduleData,
+            [&](auto & generator, uint64_t const algorithm) {
+                auto const metrics(generator.networkMetrics(elementCount));
+                // In floating point, since the costs may not fit 64 bits:
+                double const cost =
+                        static_cast<double>(metrics.depth) * roundCost
+                        + static_cast<double>(metrics.comparators)
+                          * comparisonCost;
+                if (selected && cost >= selectedCost)
+                    return;
+                selected = true;
+                selectedAlgorithm = algorithm;
+                selectedMetrics = metrics;
+                selectedCost = cost;
+                cacheSelectedNetwork =
+                    [&generator, elementCount]() {
+                        generator.getCachedOrGenerateAndCacheNetwork(
+                                    elementCount);
+                    };
+            });
+
+        assert(selected);
+        cacheSelectedNetwork();
+
+        uint64_t * const out = static_cast<uint64_t *>(refs[0u].pData);
+        out[0u] = selectedMetrics.depth;
+        out[1u] = selectedMetrics.comparators;
+        returnValue->uint64[0u] = selectedAlgorithm;
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory arguments: uint64 length of the first sorted run and uint64 length
+ * of the second sorted run.
+ * Return value: the size of the network merging the runs.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(UnequalMergingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 2u || crefs || refs || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t firstRunLength = args[0u].uint64[0u];
+    const uint64_t secondRunLength = args[1u].uint64[0u];
+
+    if (firstRunLength < 1 || secondRunLength < 1
+        || firstRunLength > std::numeric_limits<uint64_t>::max()
+                            - secondRunLength)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->unequalMergingNetworkGenerator;
+
+    try {
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(
+                           UnequalMergingNetwork::Runs(firstRunLength,
+                                                       secondRunLength));
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        returnValue->uint64[0u] = r->serializedSize();
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory arguments: uint64 length of the first sorted run and uint64 length
+ * of the second sorted run.
+ * Mandatory ref argument: uint64 array for the merging network.
+ * No return value.
+ *
+ * The network merges an input whose first and last elements of the given
+ * lengths have already been sorted. It has O((m + n) log (m + n))
+ * comparators, so appending a few elements to a long sorted array is much
+ * cheaper than sorting it again.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(UnequalMergingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 2u || crefs || !refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t firstRunLength = args[0u].uint64[0u];
+    const uint64_t secondRunLength = args[1u].uint64[0u];
+    uint64_t * const arrayStart = static_cast<uint64_t *>(refs[0u].pData);
+
+    if (firstRunLength < 1 || secondRunLength < 1
+        || firstRunLength > std::numeric_limits<uint64_t>::max()
+                            - secondRunLength)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    const size_t availableStorageSize = refs[0u].size / sizeof(uint64_t);
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->unequalMergingNetworkGenerator;
+
+    try {
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(
+                           UnequalMergingNetwork::Runs(firstRunLength,
+                                                       secondRunLength));
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        if (r->serializedSize() != availableStorageSize)
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        r->serialize(arrayStart);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory cref argument: uint64 array of the lengths of the sorted runs.
+ * Return value: the size of the network merging the runs.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MultiwayMergingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    (void) args;
+
+    if (num_args != 0u || refs || !crefs
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->multiwayMergingNetworkGenerator;
+
+    try {
+        MultiwayMergingNetwork::Runs runs;
+        if (!readMultiwayMergeRuns(crefs[0u], runs))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(runs);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        returnValue->uint64[0u] = r->serializedSize();
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory cref argument: uint64 array of the lengths of the sorted runs.
+ * Mandatory ref argument: uint64 array for the merging network.
+ * No return value.
+ *
+ * The network merges an input which consists of consecutive sorted runs of
+ * the given lengths. It is a tree of two-way merges of adjacent runs, so for
+ * k runs of N elements in total its depth is about log2(k) * log2(N).
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MultiwayMergingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    (void) args;
+
+    if (num_args != 0u || !refs || !crefs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    uint64_t * const arrayStart = static_cast<uint64_t *>(refs[0u].pData);
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    const size_t availableStorageSize = refs[0u].size / sizeof(uint64_t);
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->multiwayMergingNetworkGenerator;
+
+    try {
+        MultiwayMergingNetwork::Runs runs;
+        if (!readMultiwayMergeRuns(crefs[0u], runs))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(runs);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        if (r->serializedSize() != availableStorageSize)
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        r->serialize(arrayStart);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Mandatory ref argument: uint64 array of 3 elements which receives the depth,
+ * the number of comparators and the number of comparators in the widest stage
+ * of the sorting network.
+ * No return value.
+ *
+ * The network is not cached by this, and its metrics are derived from its
+ * construction without generating it. Only bitonic networks whose number of
+ * elements is not a power of two are generated for measuring them, and only
+ * if their modelled metrics failed the check at build time.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_metrics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t) {
+                    if (crefs || returnValue)
+                        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+                    const uint64_t elementCount = args[0u].uint64[0u];
+                    if (elementCount < 1)
+                        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+                    return networkMetrics(generator,
+                                          static_cast<size_t>(elementCount),
+                                          refs);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Mandatory ref argument: uint64 array of 3 elements which receives the depth,
+ * the number of comparators and the number of comparators in the widest stage
+ * of the merging network.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_metrics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 1u || crefs || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elementCount = args[0u].uint64[0u];
+    if (elementCount < 1)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    return networkMetrics(static_cast<ModuleData *>(c->moduleHandle)
+                              ->mergingNetworkGenerator,
+                          static_cast<size_t>(elementCount),
+                          refs);
+}
+
+/**
+ * Mandatory arguments: uint64 length of the first sorted run and uint64 length
+ * of the second sorted run.
+ * Mandatory ref argument: uint64 array of 3 elements which receives the depth,
+ * the number of comparators and the number of comparators in the widest stage
+ * of the network merging the runs.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(UnequalMergingNetwork_metrics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 2u || crefs || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t firstRunLength = args[0u].uint64[0u];
+    const uint64_t secondRunLength = args[1u].uint64[0u];
+
+    if (firstRunLength < 1 || secondRunLength < 1
+        || firstRunLength > std::numeric_limits<uint64_t>::max()
+                            - secondRunLength)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    return networkMetrics(static_cast<ModuleData *>(c->moduleHandle)
+                              ->unequalMergingNetworkGenerator,
+                          UnequalMergingNetwork::Runs(firstRunLength,
+                                                      secondRunLength),
+                          refs);
+}
+
+/**
+ * Mandatory cref argument: uint64 array of the lengths of the sorted runs.
+ * Mandatory ref argument: uint64 array of 3 elements which receives the depth,
+ * the number of comparators and the number of comparators in the widest stage
+ * of the network merging the runs.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MultiwayMergingNetwork_metrics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    (void) args;
+
+    if (num_args != 0u || !crefs
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    try {
+        MultiwayMergingNetwork::Runs runs;
+        if (!readMultiwayMergeRuns(crefs[0u], runs))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        return networkMetrics(static_cast<ModuleData *>(c->moduleHandle)
+                                  ->multiwayMergingNetworkGenerator,
+                              runs,
+                              refs);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Return value: the handle of newly allocated public memory which contains the
+ *               sorting network in the format of SortingNetwork_serialize.
+ *
+ * This replaces a call to SortingNetwork_serializedSize, the allocation of
+ * the array and a call to SortingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkAllocateAndSerialize<uint64_t>(
+                                c, generator, args, numArgs,
+                                refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * Return value: the handle of newly allocated public memory which contains the
+ *               sorting network in the format of
+ *               CompactSortingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactSortingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t const numArgs) {
+                    return networkAllocateAndSerialize<uint32_t>(
+                                c, generator, args, numArgs,
+                                refs, crefs, returnValue);
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Return value: the handle of newly allocated public memory which contains the
+ *               merging network in the format of MergingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkAllocateAndSerialize<uint64_t>(
+                c,
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Return value: the handle of newly allocated public memory which contains the
+ *               merging network in the format of
+ *               CompactMergingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactMergingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkAllocateAndSerialize<uint32_t>(
+                c,
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->mergingNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 length of the first sorted run and uint64 length
+ * of the second sorted run.
+ * Return value: the handle of newly allocated public memory which contains the
+ *               network merging the runs in the format of
+ *               UnequalMergingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(UnequalMergingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 2u || crefs || refs || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t firstRunLength = args[0u].uint64[0u];
+    const uint64_t secondRunLength = args[1u].uint64[0u];
+
+    if (firstRunLength < 1 || secondRunLength < 1
+        || firstRunLength > std::numeric_limits<uint64_t>::max()
+                            - secondRunLength)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->unequalMergingNetworkGenerator;
+
+    try {
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(
+                           UnequalMergingNetwork::Runs(firstRunLength,
+                                                       secondRunLength));
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        return allocateSerializedNetwork<uint64_t>(c, *r, returnValue);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+/**
+ * Mandatory cref argument: uint64 array of the lengths of the sorted runs.
+ * Return value: the handle of newly allocated public memory which contains the
+ *               network merging the runs in the format of
+ *               MultiwayMergingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MultiwayMergingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    (void) args;
+
+    if (num_args != 0u || refs || !crefs
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->multiwayMergingNetworkGenerator;
+
+    try {
+        MultiwayMergingNetwork::Runs runs;
+        if (!readMultiwayMergeRuns(crefs[0u], runs))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(runs);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        return allocateSerializedNetwork<uint64_t>(c, *r, returnValue);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * Optional argument: uint64 SortingNetworkAlgorithm
+ * No return value.
+ *
+ * Starts generating the sorting network in the background, so that a later
+ * call serializing it finds it in the cache. Errors in the generation are
+ * ignored, and reported by that later call instead.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SortingNetwork_prefetch,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return withSortingNetworkGenerator(
+                c, args, num_args, 1u,
+                [=](auto & generator, std::size_t) {
+                    if (crefs || refs || returnValue)
+                        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+                    const uint64_t elementCount = args[0u].uint64[0u];
+                    if (elementCount < 1)
+                        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+                    return prefetchNetwork(c, generator,
+                                           static_cast<size_t>(elementCount));
+                });
+}
+
+/**
+ * Mandatory argument: uint64 size of array to sort
+ * No return value.
+ *
+ * Starts generating the merging network in the background.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MergingNetwork_prefetch,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 1u || crefs || refs || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elementCount = args[0u].uint64[0u];
+    if (elementCount < 1)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    return prefetchNetwork(c,
+                           static_cast<ModuleData *>(c->moduleHandle)
+                               ->mergingNetworkGenerator,
+                           static_cast<size_t>(elementCount));
+}
+
+/**
+ * Mandatory arguments: uint64 length of the first sorted run and uint64 length
+ * of the second sorted run.
+ * No return value.
+ *
+ * Starts generating the network merging the runs in the background.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(UnequalMergingNetwork_prefetch,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 2u || crefs || refs || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t firstRunLength = args[0u].uint64[0u];
+    const uint64_t secondRunLength = args[1u].uint64[0u];
+
+    if (firstRunLength < 1 || secondRunLength < 1
+        || firstRunLength > std::numeric_limits<uint64_t>::max()
+                            - secondRunLength)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    return prefetchNetwork(c,
+                           static_cast<ModuleData *>(c->moduleHandle)
+                               ->unequalMergingNetworkGenerator,
+                           UnequalMergingNetwork::Runs(firstRunLength,
+                                                       secondRunLength));
+}
+
+/**
+ * Mandatory cref argument: uint64 array of the lengths of the sorted runs.
+ * No return value.
+ *
+ * Starts generating the network merging the runs in the background.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MultiwayMergingNetwork_prefetch,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    (void) args;
+
+    if (num_args != 0u || refs || !crefs
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    try {
+        MultiwayMergingNetwork::Runs runs;
+        if (!readMultiwayMergeRuns(crefs[0u], runs))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        return prefetchNetwork(c,
+                               static_cast<ModuleData *>(c->moduleHandle)
+                                   ->multiwayMergingNetworkGenerator,
+                               std::move(runs));
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+/**
+ * Mandatory argument: uint64 number of elements to permute
+ * Return value: the size of the permutation network.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(PermutationNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerializedSize(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->permutationNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory argument: uint64 number of elements to permute
+ * Mandatory ref argument: uint64 array for the permutation network
+ * No return value.
+ *
+ * The network is in the layout of SortingNetwork_serialize, but each
+ * comparator is a switch, which must not be evaluated by comparing its inputs.
+ * Instead, a switch exchanges the values on its left and right wires if and
+ * only if its bit from PermutationNetwork_switchSettings is set. The words
+ * which hold the targets of the minima and the maxima of a sorting network
+ * repeat the left and the right wires of the switches of each stage.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(PermutationNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkSerialize(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->permutationNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory argument: uint64 number of elements to permute
+ * Mandatory cref argument: uint64 array of the public permutation, i.e. the
+ * index of the input to route to each output.
+ * Mandatory ref argument: uint64 array which receives 1 for every set switch
+ * and 0 for every other switch of the permutation network, in the order in
+ * which PermutationNetwork_serialize serializes the switches.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(PermutationNetwork_switchSettings,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 1u || !crefs || !refs
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elementCount = args[0u].uint64[0u];
+    if (elementCount < 1)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    if (crefs[0u].size / sizeof(uint64_t) != elementCount)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+    const uint64_t * const permutation =
+            static_cast<const uint64_t *>(crefs[0u].pData);
+
+    try {
+        if (!PermutationNetwork::isPermutation(permutation, elementCount))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+        const auto r = static_cast<ModuleData *>(c->moduleHandle)
+                ->permutationNetworkGenerator
+                .getCachedOrGenerateAndCacheNetwork(elementCount);
+        if (refs[0u].size / sizeof(uint64_t) != r->numSwitches())
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        r->switchSettings(permutation,
+                          static_cast<uint64_t *>(refs[0u].pData));
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory ref argument: uint64 array of 5 elements which receives the number
+ * of permutation network cache hits, cache misses, evicted networks, the number
+ * of bytes used by the cached networks and the number of cached networks.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(PermutationNetwork_cacheStatistics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkCacheStatistics(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->permutationNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory argument: uint64 number of elements to select from
+ * Mandatory cref argument: uint64 array of the strictly ascending ranks to
+ * select, where rank 0 is the smallest element.
+ * Return value: the size of the selection network.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SelectionNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 1u || refs || !crefs
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->selectionNetworkGenerator;
+
+    try {
+        SelectionNetwork::Ranks ranks;
+        if (!readSelectionRanks(args[0u].uint64[0u], crefs[0u], ranks))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(ranks);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        returnValue->uint64[0u] = r->serializedSize();
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory argument: uint64 number of elements to select from
+ * Mandatory cref argument: uint64 array of the strictly ascending ranks to
+ * select, where rank 0 is the smallest element.
+ * Mandatory ref argument: uint64 array for the selection network
+ * No return value.
+ *
+ * The network is in the format of SortingNetwork_serialize. It places the
+ * element of every given rank at the position of the same index, e.g. the
+ * median of n elements at position n / 2 for odd n, but leaves the other
+ * positions only partially sorted. It needs fewer comparators than a sorting
+ * network, especially for a few ranks near either end.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SelectionNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 1u || !refs || !crefs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    uint64_t * const arrayStart = static_cast<uint64_t *>(refs[0u].pData);
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    const size_t availableStorageSize = refs[0u].size / sizeof(uint64_t);
+
+    auto & generator = static_cast<ModuleData *>(c->moduleHandle)
+                           ->selectionNetworkGenerator;
+
+    try {
+        SelectionNetwork::Ranks ranks;
+        if (!readSelectionRanks(args[0u].uint64[0u], crefs[0u], ranks))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        const auto r = generator.getCachedOrGenerateAndCacheNetwork(ranks);
+        if (!r) {
+            /// \bug This might actually be OOM or invalid argument
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        }
+        if (r->serializedSize() != availableStorageSize)
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        r->serialize(arrayStart);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
+
+/**
+ * Mandatory argument: uint64 number of elements to select from
+ * Mandatory cref argument: uint64 array of the strictly ascending ranks to
+ * select, where rank 0 is the smallest element.
+ * Mandatory ref argument: uint64 array of 3 elements which receives the depth,
+ * the number of comparators and the number of comparators in the widest stage
+ * of the selection network.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SelectionNetwork_metrics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 1u || !crefs
+        || (static_cast<void>(assert(crefs[0u].pData)), crefs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    try {
+        SelectionNetwork::Ranks ranks;
+        if (!readSelectionRanks(args[0u].uint64[0u], crefs[0u], ranks))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        return networkMetrics(static_cast<ModuleData *>(c->moduleHandle)
+                                  ->selectionNetworkGenerator,
+                              ranks,
+                              refs);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+/**
+ * Mandatory ref argument: uint64 array of 5 elements which receives the number
+ * of selection network cache hits, cache misses, evicted networks, the number
+ * of bytes used by the cached networks and the number of cached networks.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(SelectionNetwork_cacheStatistics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return networkCacheStatistics(
+                static_cast<ModuleData *>(c->moduleHandle)
+                    ->selectionNetworkGenerator,
+                args, num_args, refs, crefs, returnValue);
+}
+
 SHAREMIND_EXTERN_C_END
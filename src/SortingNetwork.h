@@ -27,5 +27,44 @@ SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_serializedSize,)
 SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_serialize,)
 SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_serializedSize,)
 SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_numStages,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_serializedStagesSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_serializeStages,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_numStages,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_serializedStagesSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_serializeStages,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactSortingNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactSortingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactMergingNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactMergingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_cacheStatistics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_cacheStatistics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_selectAlgorithm,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(UnequalMergingNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(UnequalMergingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MultiwayMergingNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MultiwayMergingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_metrics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_metrics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(UnequalMergingNetwork_metrics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MultiwayMergingNetwork_metrics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactSortingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactMergingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(UnequalMergingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MultiwayMergingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SortingNetwork_prefetch,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MergingNetwork_prefetch,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(UnequalMergingNetwork_prefetch,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MultiwayMergingNetwork_prefetch,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(PermutationNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(PermutationNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(PermutationNetwork_switchSettings,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(PermutationNetwork_cacheStatistics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SelectionNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SelectionNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SelectionNetwork_metrics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(SelectionNetwork_cacheStatistics,)
 
 #endif /* SHAREMIND_MOD_ALGORITHMS_SORTINGNETWORK_H */
@@ -0,0 +1,1345 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#include "SortingNetworkConstructions.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "NetworkBuilder.h"
+
+
+namespace /* anonymous */ {
+
+using Comparator = std::uint8_t[2];
+
+/* Best-known sorting networks for up to 16 inputs, grouped by stage. The
+   networks for up to 10 inputs are optimal in size. The network for 16
+   inputs is Green's, and the one for 15 inputs is derived from it by removing
+   the last input. */
+/* 2 inputs, 1 comparator, depth 1: */
+constexpr Comparator sortingNetwork2[] = {
+    {0, 1}
+};
+
+/* 3 inputs, 3 comparators, depth 3: */
+constexpr Comparator sortingNetwork3[] = {
+    {0, 2},
+    {0, 1},
+    {1, 2}
+};
+
+/* 4 inputs, 5 comparators, depth 3: */
+constexpr Comparator sortingNetwork4[] = {
+    {0, 2}, {1, 3},
+    {0, 1}, {2, 3},
+    {1, 2}
+};
+
+/* 5 inputs, 9 comparators, depth 5: */
+constexpr Comparator sortingNetwork5[] = {
+    {0, 3}, {1, 4},
+    {0, 2}, {1, 3},
+    {0, 1}, {2, 4},
+    {1, 2}, {3, 4},
+    {2, 3}
+};
+
+/* 6 inputs, 12 comparators, depth 5: */
+constexpr Comparator sortingNetwork6[] = {
+    {0, 5}, {1, 3}, {2, 4},
+    {1, 2}, {3, 4},
+    {0, 3}, {2, 5},
+    {0, 1}, {2, 3}, {4, 5},
+    {1, 2}, {3, 4}
+};
+
+/* 7 inputs, 16 comparators, depth 6: */
+constexpr Comparator sortingNetwork7[] = {
+    {0, 6}, {2, 3}, {4, 5},
+    {0, 2}, {1, 4}, {3, 6},
+    {0, 1}, {2, 5}, {3, 4},
+    {1, 2}, {4, 6},
+    {2, 3}, {4, 5},
+    {1, 2}, {3, 4}, {5, 6}
+};
+
+/* 8 inputs, 19 comparators, depth 6: */
+constexpr Comparator sortingNetwork8[] = {
+    {0, 2}, {1, 3}, {4, 6}, {5, 7},
+    {0, 4}, {1, 5}, {2, 6}, {3, 7},
+    {0, 1}, {2, 3}, {4, 5}, {6, 7},
+    {2, 4}, {3, 5},
+    {1, 4}, {3, 6},
+    {1, 2}, {3, 4}, {5, 6}
+};
+
+/* 9 inputs, 25 comparators, depth 7: */
+constexpr Comparator sortingNetwork9[] = {
+    {0, 3}, {1, 7}, {2, 5}, {4, 8},
+    {0, 7}, {2, 4}, {3, 8}, {5, 6},
+    {0, 2}, {1, 3}, {4, 5}, {7, 8},
+    {1, 4}, {3, 6}, {5, 7},
+    {0, 1}, {2, 4}, {3, 5}, {6, 8},
+    {2, 3}, {4, 5}, {6, 7},
+    {1, 2}, {3, 4}, {5, 6}
+};
+
+/* 10 inputs, 29 comparators, depth 8: */
+constexpr Comparator sortingNetwork10[] = {
+    {0, 8}, {1, 9}, {2, 7}, {3, 5}, {4, 6},
+    {0, 2}, {1, 4}, {5, 8}, {7, 9},
+    {0, 3}, {2, 4}, {5, 7}, {6, 9},
+    {0, 1}, {3, 6}, {8, 9},
+    {1, 5}, {2, 3}, {4, 8}, {6, 7},
+    {1, 2}, {3, 5}, {4, 6}, {7, 8},
+    {2, 3}, {4, 5}, {6, 7},
+    {3, 4}, {5, 6}
+};
+
+/* 11 inputs, 35 comparators, depth 8: */
+constexpr Comparator sortingNetwork11[] = {
+    {0, 9}, {1, 6}, {2, 4}, {3, 7}, {5, 8},
+    {0, 1}, {3, 5}, {4, 10}, {6, 9}, {7, 8},
+    {1, 3}, {2, 5}, {4, 7}, {8, 10},
+    {0, 4}, {1, 2}, {3, 7}, {5, 9}, {6, 8},
+    {0, 1}, {2, 6}, {4, 5}, {7, 8}, {9, 10},
+    {2, 4}, {3, 6}, {5, 7}, {8, 9},
+    {1, 2}, {3, 4}, {5, 6}, {7, 8},
+    {2, 3}, {4, 5}, {6, 7}
+};
+
+/* 12 inputs, 39 comparators, depth 9: */
+constexpr Comparator sortingNetwork12[] = {
+    {0, 8}, {1, 7}, {2, 6}, {3, 11}, {4, 10}, {5, 9},
+    {0, 1}, {2, 5}, {3, 4}, {6, 9}, {7, 8}, {10, 11},
+    {0, 2}, {1, 6}, {5, 10}, {9, 11},
+    {0, 3}, {1, 2}, {4, 6}, {5, 7}, {8, 11}, {9, 10},
+    {1, 4}, {3, 5}, {6, 8}, {7, 10},
+    {1, 3}, {2, 5}, {6, 9}, {8, 10},
+    {2, 3}, {4, 5}, {6, 7}, {8, 9},
+    {4, 6}, {5, 7},
+    {3, 4}, {5, 6}, {7, 8}
+};
+
+/* 13 inputs, 45 comparators, depth 10: */
+constexpr Comparator sortingNetwork13[] = {
+    {0, 12}, {1, 10}, {2, 9}, {3, 7}, {5, 11}, {6, 8},
+    {1, 6}, {2, 3}, {4, 11}, {7, 9}, {8, 10},
+    {0, 4}, {1, 2}, {3, 6}, {7, 8}, {9, 10}, {11, 12},
+    {4, 6}, {5, 9}, {8, 11}, {10, 12},
+    {0, 5}, {3, 8}, {4, 7}, {6, 11}, {9, 10},
+    {0, 1}, {2, 5}, {6, 9}, {7, 8}, {10, 11},
+    {1, 3}, {2, 4}, {5, 6}, {9, 10},
+    {1, 2}, {3, 4}, {5, 7}, {6, 8},
+    {2, 3}, {4, 5}, {6, 7}, {8, 9},
+    {3, 4}, {5, 6}
+};
+
+/* 14 inputs, 51 comparators, depth 10: */
+constexpr Comparator sortingNetwork14[] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7}, {8, 9}, {10, 11}, {12, 13},
+    {0, 2}, {1, 3}, {4, 8}, {5, 9}, {10, 12}, {11, 13},
+    {0, 4}, {1, 2}, {3, 7}, {5, 8}, {6, 10}, {9, 13}, {11, 12},
+    {0, 6}, {1, 5}, {3, 9}, {4, 10}, {7, 13}, {8, 12},
+    {2, 10}, {3, 11}, {4, 6}, {7, 9},
+    {1, 3}, {2, 8}, {5, 11}, {6, 7}, {10, 12},
+    {1, 4}, {2, 6}, {3, 5}, {7, 11}, {8, 10}, {9, 12},
+    {2, 4}, {3, 6}, {5, 8}, {7, 10}, {9, 11},
+    {3, 4}, {5, 6}, {7, 8}, {9, 10},
+    {6, 7}
+};
+
+/* 15 inputs, 56 comparators, depth 10: */
+constexpr Comparator sortingNetwork15[] = {
+    {0, 13}, {1, 12}, {3, 14}, {4, 8}, {5, 6}, {7, 11}, {9, 10},
+    {0, 5}, {1, 7}, {2, 9}, {3, 4}, {6, 13}, {8, 14}, {11, 12},
+    {0, 1}, {2, 3}, {4, 5}, {6, 8}, {7, 9}, {10, 11}, {12, 13},
+    {0, 2}, {1, 3}, {4, 10}, {5, 11}, {6, 7}, {8, 9}, {12, 14},
+    {1, 2}, {3, 12}, {4, 6}, {5, 7}, {8, 10}, {9, 11}, {13, 14},
+    {1, 4}, {2, 6}, {5, 8}, {7, 10}, {9, 13}, {11, 14},
+    {2, 4}, {3, 6}, {9, 12}, {11, 13},
+    {3, 5}, {6, 8}, {7, 9}, {10, 12},
+    {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12},
+    {6, 7}, {8, 9}
+};
+
+/* 16 inputs, 60 comparators, depth 10: */
+constexpr Comparator sortingNetwork16[] = {
+    {0, 13}, {1, 12}, {2, 15}, {3, 14}, {4, 8}, {5, 6}, {7, 11}, {9, 10},
+    {0, 5}, {1, 7}, {2, 9}, {3, 4}, {6, 13}, {8, 14}, {10, 15}, {11, 12},
+    {0, 1}, {2, 3}, {4, 5}, {6, 8}, {7, 9}, {10, 11}, {12, 13}, {14, 15},
+    {0, 2}, {1, 3}, {4, 10}, {5, 11}, {6, 7}, {8, 9}, {12, 14}, {13, 15},
+    {1, 2}, {3, 12}, {4, 6}, {5, 7}, {8, 10}, {9, 11}, {13, 14},
+    {1, 4}, {2, 6}, {5, 8}, {7, 10}, {9, 13}, {11, 14},
+    {2, 4}, {3, 6}, {9, 12}, {11, 13},
+    {3, 5}, {6, 8}, {7, 9}, {10, 12},
+    {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12},
+    {6, 7}, {8, 9}
+};
+
+struct SmallSortingNetwork {
+    std::size_t numComparators;
+    Comparator const * comparators;
+};
+
+template <std::size_t N>
+constexpr SmallSortingNetwork smallSortingNetwork(
+        Comparator const (& comparators)[N]) noexcept
+{ return {N, comparators}; }
+
+constexpr SmallSortingNetwork smallSortingNetworks[] = {
+    {0u, nullptr},
+    {0u, nullptr},
+    smallSortingNetwork(sortingNetwork2),
+    smallSortingNetwork(sortingNetwork3),
+    smallSortingNetwork(sortingNetwork4),
+    smallSortingNetwork(sortingNetwork5),
+    smallSortingNetwork(sortingNetwork6),
+    smallSortingNetwork(sortingNetwork7),
+    smallSortingNetwork(sortingNetwork8),
+    smallSortingNetwork(sortingNetwork9),
+    smallSortingNetwork(sortingNetwork10),
+    smallSortingNetwork(sortingNetwork11),
+    smallSortingNetwork(sortingNetwork12),
+    smallSortingNetwork(sortingNetwork13),
+    smallSortingNetwork(sortingNetwork14),
+    smallSortingNetwork(sortingNetwork15),
+    smallSortingNetwork(sortingNetwork16)
+};
+static_assert(sizeof(smallSortingNetworks) / sizeof(smallSortingNetworks[0u])
+              == maxSmallSortingNetworkElements + 1u,
+              "A small sorting network is missing!");
+
+/**
+  \brief Receives the comparators of a network in reverse order, and marks
+         those on which any of its outputs on the given wires depends.
+  \details Walking the network backwards, a comparator is needed if either of
+           its outputs is, and then both of its inputs are. The constructions
+           below add their comparators to a NetworkPruner in reverse order,
+           see inOrder(), and are repeated with a PrunedNetworkBuilder to add
+           the marked comparators in the order of the network, so a network is
+           pruned with a single bit per comparator.
+*/
+class NetworkPruner {
+
+public: /* Methods: */
+
+    NetworkPruner(std::size_t const numInputs,
+                  std::vector<std::size_t> const & outputs)
+        : m_neededWires(numInputs, false)
+    {
+        for (auto const output : outputs)
+            m_neededWires[output] = true;
+    }
+
+    void addComparator(std::size_t const min, std::size_t const max) {
+        assert(min < numInputs());
+        assert(max < numInputs());
+        bool const needed = m_neededWires[min] || m_neededWires[max];
+        if (needed) {
+            m_neededWires[min] = m_neededWires[max] = true;
+            ++m_numNeeded;
+        }
+        m_needed.push_back(needed);
+    }
+
+    std::size_t numInputs() const noexcept { return m_neededWires.size(); }
+
+    /** \returns the number of comparators which are needed. */
+    std::size_t numComparators() const noexcept { return m_numNeeded; }
+
+    /** \returns whether the i-th comparator of the network is needed. */
+    bool needed(std::size_t const i) const noexcept {
+        assert(i < m_needed.size());
+        return m_needed[m_needed.size() - 1u - i];
+    }
+
+private: /* Fields: */
+
+    std::vector<bool> m_neededWires;
+    /** For every comparator in the order received, whether it is needed. */
+    std::vector<bool> m_needed;
+    std::size_t m_numNeeded = 0u;
+
+}; /* class NetworkPruner { */
+
+/**
+  \brief Adds the comparators of a network which the given NetworkPruner found
+         to be needed to a NetworkBuilder.
+*/
+class PrunedNetworkBuilder {
+
+public: /* Methods: */
+
+    PrunedNetworkBuilder(NetworkBuilder & builder,
+                         NetworkPruner const & pruner) noexcept
+        : m_builder(builder)
+        , m_pruner(pruner)
+    { assert(builder.numInputs() == pruner.numInputs()); }
+
+    void addComparator(std::size_t const min, std::size_t const max) {
+        if (m_pruner.needed(m_next++))
+            m_builder.addComparator(min, max);
+    }
+
+    std::size_t numInputs() const noexcept { return m_builder.numInputs(); }
+
+private: /* Fields: */
+
+    NetworkBuilder & m_builder;
+    NetworkPruner const & m_pruner;
+    std::size_t m_next = 0u;
+
+}; /* class PrunedNetworkBuilder { */
+
+/** \brief Calls first() and then second(). */
+template <typename Builder, typename First, typename Second>
+void inOrder(Builder &, First && first, Second && second) {
+    first();
+    second();
+}
+
+/** \brief Calls second() and then first(), as NetworkPruner goes backwards. */
+template <typename First, typename Second>
+void inOrder(NetworkPruner &, First && first, Second && second) {
+    second();
+    first();
+}
+
+/** \brief Calls f(i) for every i < count in ascending order. */
+template <typename Builder, typename F>
+void forEachInOrder(Builder &, std::size_t const count, F && f) {
+    for (std::size_t i = 0u; i < count; ++i)
+        f(i);
+}
+
+/** \brief Calls f(i) for every i < count in descending order. */
+template <typename F>
+void forEachInOrder(NetworkPruner &, std::size_t const count, F && f) {
+    for (std::size_t i = count; i-- > 0u;)
+        f(i);
+}
+
+/** \brief Adds the comparators of the small sorting network on the wires
+           [first, first + elements). */
+template <typename Builder>
+void addSmallSortingNetwork(Builder & builder,
+                            std::size_t const first,
+                            std::size_t const elements)
+{
+    assert(elements <= maxSmallSortingNetworkElements);
+    auto const & network = smallSortingNetworks[elements];
+    forEachInOrder(builder,
+                   network.numComparators,
+                   [&builder, first, &network](std::size_t const i) {
+                       builder.addComparator(
+                               first + network.comparators[i][0u],
+                               first + network.comparators[i][1u]);
+                   });
+}
+
+std::size_t nextPowerOfTwo(std::size_t const n) noexcept {
+    std::size_t r = 1u;
+    while (r < n)
+        r *= 2u;
+    return r;
+}
+
+/**
+  \brief Adds the comparators of the pairwise sorting network for the count
+         wires offset, offset + stride, offset + 2 * stride, ...
+  \pre count is a power of two.
+*/
+template <typename Builder>
+void addPairwiseSortingNetwork(Builder & builder,
+                               std::size_t const offset,
+                               std::size_t const stride,
+                               std::size_t const count)
+{
+    assert(count > 0u && (count & (count - 1u)) == 0u);
+    std::size_t const n = builder.numInputs();
+    if (count < 2u || offset + stride >= n)
+        return;
+
+    auto const compare =
+        [&builder, n, offset, stride](std::size_t const i, std::size_t const j)
+        {
+            // Comparators on the missing elements are dropped:
+            if (offset + stride * j < n)
+                builder.addComparator(offset + stride * i,
+                                      offset + stride * j);
+        };
+
+    // Sort the pairs:
+    auto const sortPairs = [&builder, &compare, count]() {
+        forEachInOrder(builder,
+                       count / 2u,
+                       [&compare](std::size_t const pair)
+                       { compare(2u * pair, 2u * pair + 1u); });
+    };
+
+    // Sort the smaller and the larger elements of the pairs:
+    auto const sortHalves = [&builder, offset, stride, count]() {
+        inOrder(builder,
+                [&builder, offset, stride, count]() {
+                    addPairwiseSortingNetwork(builder,
+                                              offset,
+                                              2u * stride,
+                                              count / 2u);
+                },
+                [&builder, offset, stride, count]() {
+                    addPairwiseSortingNetwork(builder,
+                                              offset + stride,
+                                              2u * stride,
+                                              count / 2u);
+                });
+    };
+
+    /* Merge them in the steps m = count / 2, count / 4, ..., 2, which
+       compare the odd positions i to i + m - 1: */
+    std::size_t mergeSteps = 0u;
+    for (std::size_t m = count / 2u; m > 1u; m /= 2u)
+        ++mergeSteps;
+    auto const merge = [&builder, &compare, count, mergeSteps]() {
+        forEachInOrder(
+                builder,
+                mergeSteps,
+                [&builder, &compare, count](std::size_t const step) {
+                    std::size_t const m = (count / 2u) >> step;
+                    forEachInOrder(builder,
+                                   (count - m + 1u) / 2u,
+                                   [&compare, m](std::size_t const k) {
+                                       compare(2u * k + 1u, 2u * k + m);
+                                   });
+                });
+    };
+
+    inOrder(builder,
+            sortPairs,
+            [&sortHalves, &merge, &builder]()
+            { inOrder(builder, sortHalves, merge); });
+}
+
+using Wires = std::vector<std::size_t>;
+
+/**
+  \brief Adds the comparators of Batcher's odd-even merging network which
+         merges the sorted runs on the ascending wires x and y.
+  \details The runs may have any lengths. The minimum of every comparator is
+           routed to its lower wire, so if all wires of x precede those of y,
+           the merged run ends up on the wires of x and y in ascending order.
+*/
+template <typename Builder>
+void addOddEvenMergingNetwork(Builder & builder,
+                              Wires const & x,
+                              Wires const & y)
+{
+    if (x.empty() || y.empty())
+        return;
+    if (x.size() == 1u && y.size() == 1u)
+        return builder.addComparator(x[0u], y[0u]);
+
+    // Merge the elements at even and odd positions of the runs separately:
+    Wires xs[2u];
+    Wires ys[2u];
+    for (std::size_t i = 0u; i < x.size(); ++i)
+        xs[i % 2u].push_back(x[i]);
+    for (std::size_t i = 0u; i < y.size(); ++i)
+        ys[i % 2u].push_back(y[i]);
+    auto const mergeParts = [&builder, &xs, &ys]() {
+        inOrder(builder,
+                [&builder, &xs, &ys]()
+                { addOddEvenMergingNetwork(builder, xs[0u], ys[0u]); },
+                [&builder, &xs, &ys]()
+                { addOddEvenMergingNetwork(builder, xs[1u], ys[1u]); });
+    };
+
+    // Interleave them, fixing the pairs which are out of order:
+    auto const interleave = [&builder, &xs, &ys]() {
+        // Both merged runs are on their wires in ascending order:
+        Wires v;
+        Wires w;
+        v.reserve(xs[0u].size() + ys[0u].size());
+        w.reserve(xs[1u].size() + ys[1u].size());
+        std::merge(xs[0u].begin(), xs[0u].end(),
+                   ys[0u].begin(), ys[0u].end(),
+                   std::back_inserter(v));
+        std::merge(xs[1u].begin(), xs[1u].end(),
+                   ys[1u].begin(), ys[1u].end(),
+                   std::back_inserter(w));
+        forEachInOrder(builder,
+                       std::min(v.size() - 1u, w.size()),
+                       [&builder, &v, &w](std::size_t const i) {
+                           builder.addComparator(std::min(v[i + 1u], w[i]),
+                                                 std::max(v[i + 1u], w[i]));
+                       });
+    };
+
+    inOrder(builder, mergeParts, interleave);
+}
+
+/**
+  \brief Adds the comparators of Batcher's odd-even merging network which
+         merges the sorted wires [first, first + m) and
+         [first + m, first + m + n).
+*/
+template <typename Builder>
+void addOddEvenMergingNetwork(Builder & builder,
+                              std::size_t const first,
+                              std::size_t const m,
+                              std::size_t const n)
+{
+    Wires x(m);
+    Wires y(n);
+    std::iota(x.begin(), x.end(), first);
+    std::iota(y.begin(), y.end(), first + m);
+    addOddEvenMergingNetwork(builder, x, y);
+}
+
+/**
+  \brief Adds the comparators of an odd-even merge sorting network on the
+         wires [first, first + n).
+  \details Runs of up to maxSmallSortingNetworkElements wires are sorted with
+           the best-known small networks.
+*/
+template <typename Builder>
+void addOddEvenMergeSortingNetwork(Builder & builder,
+                                   std::size_t const first,
+                                   std::size_t const n)
+{
+    if (n <= maxSmallSortingNetworkElements)
+        return addSmallSortingNetwork(builder, first, n);
+
+    std::size_t const m = (n + 1u) / 2u;
+    inOrder(builder,
+            [&builder, first, m, n]() {
+                inOrder(builder,
+                        [&builder, first, m]()
+                        { addOddEvenMergeSortingNetwork(builder, first, m); },
+                        [&builder, first, m, n]() {
+                            addOddEvenMergeSortingNetwork(builder,
+                                                          first + m,
+                                                          n - m);
+                        });
+            },
+            [&builder, first, m, n]()
+            { addOddEvenMergingNetwork(builder, first, m, n - m); });
+}
+
+/** The depth and the number of comparators of a network. */
+struct NetworkCost {
+    std::size_t depth;
+    std::size_t comparators;
+
+    bool operator<(NetworkCost const & rhs) const noexcept {
+        return depth != rhs.depth
+               ? depth < rhs.depth
+               : comparators < rhs.comparators;
+    }
+};
+
+/**
+  \brief Computes the cost of addOddEvenMergingNetwork() for runs of the given
+         lengths without constructing the network.
+  \details The depth is that of the recursive construction, which is an upper
+           bound of the depth of the built network.
+*/
+class OddEvenMergingNetworkCosts {
+
+public: /* Methods: */
+
+    NetworkCost operator()(std::size_t const m, std::size_t const n) {
+        if (m == 0u || n == 0u)
+            return {0u, 0u};
+        if (m == 1u && n == 1u)
+            return {1u, 1u};
+
+        auto const it(m_costs.find(std::make_pair(m, n)));
+        if (it != m_costs.cend())
+            return it->second;
+
+        auto const even((*this)((m + 1u) / 2u, (n + 1u) / 2u));
+        auto const odd((*this)(m / 2u, n / 2u));
+        std::size_t const interleaving =
+                std::min((m + 1u) / 2u + (n + 1u) / 2u - 1u, m / 2u + n / 2u);
+        NetworkCost const r{
+            std::max(even.depth, odd.depth) + (interleaving ? 1u : 0u),
+            even.comparators + odd.comparators + interleaving};
+        m_costs.emplace(std::make_pair(m, n), r);
+        return r;
+    }
+
+private: /* Fields: */
+
+    std::map<std::pair<std::size_t, std::size_t>, NetworkCost> m_costs;
+
+};
+
+using Splits = std::vector<std::vector<std::size_t> >;
+
+/**
+  \brief Plans the tree of merges of a multiway merging network.
+  \param[in] prefixSums The numbers of elements before each run, followed by
+                        the total number of elements.
+  \returns the splits, where splits[i][j] is the last run of the first part
+           when merging the runs [i, j], or nothing if the runs are to be
+           merged in a balanced tree.
+*/
+Splits planMultiwayMergingNetwork(std::vector<std::size_t> const & prefixSums)
+{
+    assert(!prefixSums.empty());
+    std::size_t const k = prefixSums.size() - 1u;
+
+    // Merge larger numbers of runs in a balanced tree:
+    if (k < 2u || k > maxPlannedMultiwayMergeRuns)
+        return Splits();
+
+    /* Plan the tree of merges of adjacent runs with the least depth and then
+       the fewest comparators by dynamic programming over ranges of runs: */
+    OddEvenMergingNetworkCosts mergeCosts;
+    std::vector<std::vector<NetworkCost> > costs(
+                k,
+                std::vector<NetworkCost>(k, NetworkCost{0u, 0u}));
+    Splits splits(k, std::vector<std::size_t>(k, 0u));
+    for (std::size_t length = 2u; length <= k; ++length) {
+        for (std::size_t i = 0u; i + length <= k; ++i) {
+            std::size_t const j = i + length - 1u;
+            for (std::size_t split = i; split < j; ++split) {
+                auto const merge(
+                        mergeCosts(prefixSums[split + 1u] - prefixSums[i],
+                                   prefixSums[j + 1u]
+                                   - prefixSums[split + 1u]));
+                NetworkCost const cost{
+                    std::max(costs[i][split].depth,
+                             costs[split + 1u][j].depth) + merge.depth,
+                    costs[i][split].comparators
+                    + costs[split + 1u][j].comparators
+                    + merge.comparators};
+                if (split == i || cost < costs[i][j]) {
+                    costs[i][j] = cost;
+                    splits[i][j] = split;
+                }
+            }
+        }
+    }
+    return splits;
+}
+
+/**
+  \returns the last run of the first part when merging the runs
+           [firstRun, lastRun] as planned in splits, or in a balanced tree if
+           there is no plan.
+*/
+std::size_t multiwayMergeSplit(Splits const & splits,
+                               std::size_t const firstRun,
+                               std::size_t const lastRun) noexcept
+{
+    return splits.empty()
+           ? firstRun + (lastRun - firstRun) / 2u
+           : splits[firstRun][lastRun];
+}
+
+/**
+  \brief Adds the comparators merging the runs [firstRun, lastRun] as planned
+         in splits.
+  \param[in] prefixSums The numbers of elements before each run.
+*/
+void addMultiwayMergingNetwork(NetworkBuilder & builder,
+                               std::vector<std::size_t> const & prefixSums,
+                               Splits const & splits,
+                               std::size_t const firstRun,
+                               std::size_t const lastRun)
+{
+    if (firstRun == lastRun)
+        return;
+    std::size_t const split = multiwayMergeSplit(splits, firstRun, lastRun);
+    addMultiwayMergingNetwork(builder, prefixSums, splits, firstRun, split);
+    addMultiwayMergingNetwork(builder, prefixSums, splits, split + 1u, lastRun);
+    addOddEvenMergingNetwork(builder,
+                             prefixSums[firstRun],
+                             prefixSums[split + 1u] - prefixSums[firstRun],
+                             prefixSums[lastRun + 1u] - prefixSums[split + 1u]);
+}
+
+/** \returns the numbers of elements before each run, and their total. */
+std::vector<std::size_t> runPrefixSums(std::vector<std::size_t> const & runs)
+{
+    std::vector<std::size_t> r(runs.size() + 1u, 0u);
+    for (std::size_t i = 0u; i < runs.size(); ++i)
+        r[i + 1u] = r[i] + runs[i];
+    return r;
+}
+
+/**
+  \brief Adds a network merging consecutive sorted runs of the given lengths,
+         as described for makeMultiwayMergingNetwork().
+  \pre The builder has as many inputs as the runs have elements in total.
+*/
+void addMultiwayMergingNetwork(NetworkBuilder & builder,
+                               std::vector<std::size_t> const & runs)
+{
+    auto const prefixSums(runPrefixSums(runs));
+    assert(builder.numInputs() == prefixSums.back());
+    if (runs.size() < 2u)
+        return;
+    addMultiwayMergingNetwork(builder,
+                              prefixSums,
+                              planMultiwayMergingNetwork(prefixSums),
+                              0u,
+                              runs.size() - 1u);
+}
+
+/** \returns the total number of elements in the runs. */
+std::size_t totalRunLength(std::vector<std::size_t> const & runs) noexcept
+{ return std::accumulate(runs.begin(), runs.end(), std::size_t(0u)); }
+
+/**
+  \brief Adds the comparators of the pruned sorting network with the fewest
+         comparators, and then the least depth, which places the elements of
+         the given ranks onto the wires of the same indices.
+  \details The sorting networks are generated backwards to prune them and
+           again to add the needed comparators, so their comparators are never
+           stored.
+*/
+void addSelectionNetwork(NetworkBuilder & builder,
+                         std::vector<std::size_t> const & ranks)
+{
+    assert(!ranks.empty());
+    assert(std::is_sorted(ranks.begin(), ranks.end()));
+    assert(ranks.back() < builder.numInputs());
+    std::size_t const n = builder.numInputs();
+    auto const addOddEvenMergeSort =
+            [n](auto & b) { addOddEvenMergeSortingNetwork(b, 0u, n); };
+    auto const addPairwiseSort =
+            [n](auto & b)
+            { addPairwiseSortingNetwork(b, 0u, 1u, nextPowerOfTwo(n)); };
+
+    NetworkPruner oddEven(n, ranks);
+    addOddEvenMergeSort(oddEven);
+    NetworkPruner pairwise(n, ranks);
+    addPairwiseSort(pairwise);
+
+    bool usePairwise = pairwise.numComparators() < oddEven.numComparators();
+    if (pairwise.numComparators() == oddEven.numComparators()) {
+        NetworkBuilder oddEvenMeasured(n, true);
+        PrunedNetworkBuilder oddEvenPruned(oddEvenMeasured, oddEven);
+        addOddEvenMergeSort(oddEvenPruned);
+        NetworkBuilder pairwiseMeasured(n, true);
+        PrunedNetworkBuilder pairwisePruned(pairwiseMeasured, pairwise);
+        addPairwiseSort(pairwisePruned);
+        usePairwise =
+                pairwiseMeasured.numStages() < oddEvenMeasured.numStages();
+    }
+
+    if (usePairwise) {
+        PrunedNetworkBuilder pruned(builder, pairwise);
+        addPairwiseSort(pruned);
+    } else {
+        PrunedNetworkBuilder pruned(builder, oddEven);
+        addOddEvenMergeSort(pruned);
+    }
+}
+
+/**
+  \brief Throws like the constructor of NetworkBuilder if a network with the
+         given number of inputs could not be built.
+*/
+void checkNumInputs(std::size_t const n) {
+    if (n > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("Too many network inputs!");
+}
+
+/**
+  \brief The depths of consecutive wires as a NetworkBuilder sees them, i.e.
+         the numbers of stages up to their last comparators, stored as runs
+         of wires of equal depth.
+  \details The constructions recursively split their wires into halves or the
+           wires of even and odd positions, and give most wires of a part the
+           same depth, so the profiles of the parts have only a few runs.
+*/
+class DepthProfile {
+
+public: /* Types: */
+
+    struct Run {
+        std::size_t depth;
+        std::size_t wires;
+
+        bool operator<(Run const & rhs) const noexcept {
+            return depth != rhs.depth
+                   ? depth < rhs.depth
+                   : wires < rhs.wires;
+        }
+    };
+
+public: /* Methods: */
+
+    DepthProfile() noexcept = default;
+
+    DepthProfile(std::size_t const wires, std::size_t const depth)
+    { append(wires, depth); }
+
+    std::size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return !m_size; }
+    std::vector<Run> const & runs() const noexcept { return m_runs; }
+
+    void append(std::size_t const wires, std::size_t const depth) {
+        if (!wires)
+            return;
+        if (!m_runs.empty() && m_runs.back().depth == depth) {
+            m_runs.back().wires += wires;
+        } else {
+            m_runs.push_back(Run{depth, wires});
+        }
+        m_size += wires;
+    }
+
+    void append(DepthProfile const & profile) {
+        for (auto const & run : profile.m_runs)
+            append(run.wires, run.depth);
+    }
+
+    /** \returns the profile of the wires [first, first + count). */
+    DepthProfile slice(std::size_t first, std::size_t count) const {
+        assert(first + count <= m_size);
+        DepthProfile r;
+        for (auto const & run : m_runs) {
+            if (!count)
+                break;
+            if (first >= run.wires) {
+                first -= run.wires;
+                continue;
+            }
+            std::size_t const wires = std::min(run.wires - first, count);
+            r.append(wires, run.depth);
+            count -= wires;
+            first = 0u;
+        }
+        return r;
+    }
+
+    /** \returns the profile of the wires [first, size()). */
+    DepthProfile slice(std::size_t const first) const
+    { return slice(first, m_size - first); }
+
+    /** \returns the profile of the wires at even or odd positions. */
+    DepthProfile parity(std::size_t const odd) const {
+        assert(odd < 2u);
+        // The number of wires of the parity before the given position:
+        auto const before = [odd](std::size_t const position) noexcept
+                            { return (position + 1u - odd) / 2u; };
+        DepthProfile r;
+        std::size_t position = 0u;
+        for (auto const & run : m_runs) {
+            r.append(before(position + run.wires) - before(position),
+                     run.depth);
+            position += run.wires;
+        }
+        return r;
+    }
+
+    std::size_t minDepth() const noexcept {
+        std::size_t r = m_runs.empty() ? 0u : m_runs.front().depth;
+        for (auto const & run : m_runs)
+            r = std::min(r, run.depth);
+        return r;
+    }
+
+    /** \brief Decreases the depths of all wires by delta. */
+    void lower(std::size_t const delta) noexcept {
+        for (auto & run : m_runs)
+            run.depth -= delta;
+    }
+
+    /** \brief Increases the depths of all wires by delta. */
+    void raise(std::size_t const delta) noexcept {
+        for (auto & run : m_runs)
+            run.depth += delta;
+    }
+
+    /** \returns the depths of the pairs of the wires of a and b at the same
+                 positions after a comparator on each pair. */
+    static DepthProfile compare(DepthProfile const & a,
+                                DepthProfile const & b)
+    {
+        assert(a.size() == b.size());
+        DepthProfile r;
+        auto i(a.m_runs.cbegin());
+        auto j(b.m_runs.cbegin());
+        std::size_t usedA = 0u;
+        std::size_t usedB = 0u;
+        while (i != a.m_runs.cend()) {
+            std::size_t const wires = std::min(i->wires - usedA,
+                                               j->wires - usedB);
+            r.append(wires, std::max(i->depth, j->depth) + 1u);
+            if ((usedA += wires) == i->wires) {
+                ++i;
+                usedA = 0u;
+            }
+            if ((usedB += wires) == j->wires) {
+                ++j;
+                usedB = 0u;
+            }
+        }
+        return r;
+    }
+
+    /**
+      \returns the profile of the wires a[0], b[0], a[1], b[1], ...
+      \pre a.size() == b.size() || a.size() == b.size() + 1u
+    */
+    static DepthProfile interleave(DepthProfile const & a,
+                                   DepthProfile const & b)
+    {
+        assert(a.size() == b.size() || a.size() == b.size() + 1u);
+        DepthProfile r;
+        auto i(a.m_runs.cbegin());
+        auto j(b.m_runs.cbegin());
+        std::size_t usedA = 0u;
+        std::size_t usedB = 0u;
+        while (j != b.m_runs.cend()) {
+            std::size_t const pairs = std::min(i->wires - usedA,
+                                               j->wires - usedB);
+            if (i->depth == j->depth) {
+                r.append(2u * pairs, i->depth);
+            } else {
+                for (std::size_t k = 0u; k < pairs; ++k) {
+                    r.append(1u, i->depth);
+                    r.append(1u, j->depth);
+                }
+            }
+            if ((usedA += pairs) == i->wires) {
+                ++i;
+                usedA = 0u;
+            }
+            if ((usedB += pairs) == j->wires) {
+                ++j;
+                usedB = 0u;
+            }
+        }
+        if (i != a.m_runs.cend())
+            r.append(1u, i->depth);
+        return r;
+    }
+
+private: /* Fields: */
+
+    std::vector<Run> m_runs;
+    std::size_t m_size = 0u;
+
+}; /* class DepthProfile { */
+
+/**
+  \brief The depths of the wires after a part of a network, and the numbers
+         of comparators which the part places in each stage.
+*/
+struct NetworkShape {
+
+    /** \brief Adds the comparators of the given part to this one. */
+    void addStages(std::vector<std::size_t> const & widths) {
+        if (stageWidths.size() < widths.size())
+            stageWidths.resize(widths.size(), 0u);
+        for (std::size_t s = 0u; s < widths.size(); ++s)
+            stageWidths[s] += widths[s];
+    }
+
+    /** \brief Adds a comparator on each pair of wires of the given depths. */
+    void addComparators(DepthProfile const & depths) {
+        for (auto const & run : depths.runs()) {
+            if (stageWidths.size() <= run.depth)
+                stageWidths.resize(run.depth + 1u, 0u);
+            stageWidths[run.depth] += run.wires;
+        }
+    }
+
+    NetworkMetrics metrics() const noexcept {
+        NetworkMetrics r{stageWidths.size(), 0u, 0u};
+        for (auto const width : stageWidths) {
+            r.comparators += width;
+            r.maxStageWidth = std::max<std::uint64_t>(r.maxStageWidth, width);
+        }
+        return r;
+    }
+
+    DepthProfile outputs;
+    std::vector<std::size_t> stageWidths;
+
+};
+
+/**
+  \brief Measures the networks of the recursive constructions by simulating
+         how a NetworkBuilder places their comparators into stages.
+  \details Instead of single comparators, the simulation handles the
+           comparators of a step of a construction on all wires of equal
+           depth at once, and remembers the shapes of the parts of the
+           networks which depend only on the sizes and the depth profiles of
+           their inputs. Up to a shift of all depths, the parts repeat at
+           every level of the recursion, so measuring a network of n elements
+           takes about O(log^2 n) steps instead of one per comparator, and
+           gives exactly the metrics of the built network.
+*/
+class NetworkShapes {
+
+public: /* Methods: */
+
+    /** \returns the shape of addOddEvenMergingNetwork() on runs x and y. */
+    NetworkShape oddEvenMerge(DepthProfile x, DepthProfile y) {
+        if (x.empty() || y.empty()) {
+            NetworkShape r;
+            r.outputs = std::move(x);
+            r.outputs.append(y);
+            return r;
+        }
+
+        std::size_t const base = std::min(x.minDepth(), y.minDepth());
+        x.lower(base);
+        y.lower(base);
+        auto key(std::make_pair(x.runs(), y.runs()));
+        auto it(m_merges.find(key));
+        if (it == m_merges.end())
+            it = m_merges.emplace(std::move(key),
+                                  measureOddEvenMerge(x, y)).first;
+        return shifted(it->second, base);
+    }
+
+    /** \returns the shape of addOddEvenMergeSortingNetwork() on n wires. */
+    NetworkShape const & oddEvenMergeSort(std::size_t const n) {
+        auto it(m_sorts.find(n));
+        if (it != m_sorts.end())
+            return it->second;
+
+        NetworkShape r;
+        if (n <= maxSmallSortingNetworkElements) {
+            r = smallSort(n);
+        } else {
+            std::size_t const m = (n + 1u) / 2u;
+            auto const first(oddEvenMergeSort(m));
+            auto const & second = oddEvenMergeSort(n - m);
+            r.addStages(first.stageWidths);
+            r.addStages(second.stageWidths);
+            auto merge(oddEvenMerge(first.outputs, second.outputs));
+            r.addStages(merge.stageWidths);
+            r.outputs = std::move(merge.outputs);
+        }
+        return m_sorts.emplace(n, std::move(r)).first->second;
+    }
+
+    /**
+      \returns the shape of addPairwiseSortingNetwork() for count wires of
+               which the ones of the given depths exist.
+    */
+    NetworkShape pairwiseSort(std::size_t const count, DepthProfile inputs) {
+        std::size_t const base = inputs.minDepth();
+        inputs.lower(base);
+        auto key(std::make_pair(count, inputs.runs()));
+        auto it(m_pairwiseSorts.find(key));
+        if (it == m_pairwiseSorts.end())
+            it = m_pairwiseSorts.emplace(std::move(key),
+                                         measurePairwiseSort(count, inputs))
+                 .first;
+        return shifted(it->second, base);
+    }
+
+private: /* Methods: */
+
+    static NetworkShape shifted(NetworkShape r, std::size_t const base) {
+        if (!r.stageWidths.empty())
+            r.stageWidths.insert(r.stageWidths.begin(), base, 0u);
+        r.outputs.raise(base);
+        return r;
+    }
+
+    static NetworkShape smallSort(std::size_t const n) {
+        auto const & network = smallSortingNetworks[n];
+        NetworkShape r;
+        std::vector<std::size_t> depths(n, 0u);
+        for (std::size_t i = 0u; i < network.numComparators; ++i) {
+            auto & a = depths[network.comparators[i][0u]];
+            auto & b = depths[network.comparators[i][1u]];
+            r.addComparators(DepthProfile(1u, std::max(a, b)));
+            a = b = std::max(a, b) + 1u;
+        }
+        for (auto const depth : depths)
+            r.outputs.append(1u, depth);
+        return r;
+    }
+
+    NetworkShape measureOddEvenMerge(DepthProfile const & x,
+                                     DepthProfile const & y)
+    {
+        NetworkShape r;
+        if (x.size() == 1u && y.size() == 1u) {
+            DepthProfile const depths(1u, std::max(x.minDepth(),
+                                                   y.minDepth()));
+            r.addComparators(depths);
+            r.outputs = DepthProfile(2u, depths.minDepth() + 1u);
+            return r;
+        }
+
+        // The merges of the wires at even and at odd positions:
+        auto const even(oddEvenMerge(x.parity(0u), y.parity(0u)));
+        auto const odd(oddEvenMerge(x.parity(1u), y.parity(1u)));
+        r.addStages(even.stageWidths);
+        r.addStages(odd.stageWidths);
+
+        // Their interleaving compares v[i] with w[i - 1]:
+        auto v(even.outputs);
+        auto w(odd.outputs);
+        std::size_t const pairs = std::min(v.size() - 1u, w.size());
+        if (pairs) {
+            auto const compared(
+                    DepthProfile::compare(v.slice(1u, pairs),
+                                          w.slice(0u, pairs)));
+            DepthProfile inputs(compared);
+            inputs.lower(1u);
+            r.addComparators(inputs);
+            DepthProfile newV(v.slice(0u, 1u));
+            newV.append(compared);
+            newV.append(v.slice(pairs + 1u));
+            DepthProfile newW(compared);
+            newW.append(w.slice(pairs));
+            v = std::move(newV);
+            w = std::move(newW);
+        }
+
+        /* The wires of v and w are those of the even and odd positions of x
+           followed by those of y: */
+        std::size_t const xEven = (x.size() + 1u) / 2u;
+        std::size_t const xOdd = x.size() / 2u;
+        r.outputs = DepthProfile::interleave(v.slice(0u, xEven),
+                                             w.slice(0u, xOdd));
+        r.outputs.append(DepthProfile::interleave(v.slice(xEven),
+                                                  w.slice(xOdd)));
+        return r;
+    }
+
+    NetworkShape measurePairwiseSort(std::size_t const count,
+                                     DepthProfile const & inputs)
+    {
+        NetworkShape r;
+        std::size_t const n = inputs.size();
+        if (count < 2u || n < 2u) {
+            r.outputs = inputs;
+            return r;
+        }
+
+        // Sort the pairs:
+        std::size_t const pairs = n / 2u;
+        auto even(inputs.parity(0u));
+        auto odd(inputs.parity(1u));
+        auto compared(DepthProfile::compare(even.slice(0u, pairs), odd));
+        {
+            DepthProfile comparatorDepths(compared);
+            comparatorDepths.lower(1u);
+            r.addComparators(comparatorDepths);
+        }
+        compared.append(even.slice(pairs));
+        even = std::move(compared);
+        odd = even.slice(0u, pairs);
+
+        // Sort the smaller and the larger elements of the pairs:
+        {
+            auto evenSort(pairwiseSort(count / 2u, std::move(even)));
+            auto oddSort(pairwiseSort(count / 2u, std::move(odd)));
+            r.addStages(evenSort.stageWidths);
+            r.addStages(oddSort.stageWidths);
+            even = std::move(evenSort.outputs);
+            odd = std::move(oddSort.outputs);
+        }
+
+        /* Merge them, where the comparator of the odd position i = 2t + 1
+           and the even position j = 2t + m exists if j < n: */
+        for (std::size_t m = count / 2u; m > 1u; m /= 2u) {
+            if (n <= m)
+                continue;
+            std::size_t const steps = (n - m + 1u) / 2u;
+            std::size_t const firstEven = m / 2u;
+            auto const merged(
+                    DepthProfile::compare(odd.slice(0u, steps),
+                                          even.slice(firstEven, steps)));
+            DepthProfile comparatorDepths(merged);
+            comparatorDepths.lower(1u);
+            r.addComparators(comparatorDepths);
+            DepthProfile newOdd(merged);
+            newOdd.append(odd.slice(steps));
+            DepthProfile newEven(even.slice(0u, firstEven));
+            newEven.append(merged);
+            newEven.append(even.slice(firstEven + steps));
+            odd = std::move(newOdd);
+            even = std::move(newEven);
+        }
+        r.outputs = DepthProfile::interleave(even, odd);
+        return r;
+    }
+
+private: /* Fields: */
+
+    using Runs = std::vector<DepthProfile::Run>;
+
+    std::map<std::pair<Runs, Runs>, NetworkShape> m_merges;
+    std::map<std::size_t, NetworkShape> m_sorts;
+    std::map<std::pair<std::size_t, Runs>, NetworkShape> m_pairwiseSorts;
+
+}; /* class NetworkShapes { */
+
+/**
+  \returns the shape of the merges of the runs [firstRun, lastRun] as planned
+           in splits.
+*/
+NetworkShape multiwayMergingNetworkShape(
+        NetworkShapes & shapes,
+        std::vector<std::size_t> const & prefixSums,
+        Splits const & splits,
+        std::size_t const firstRun,
+        std::size_t const lastRun)
+{
+    if (firstRun == lastRun)
+        return NetworkShape{
+            DepthProfile(prefixSums[lastRun + 1u] - prefixSums[firstRun], 0u),
+            {}};
+    std::size_t const split = multiwayMergeSplit(splits, firstRun, lastRun);
+    auto const first(multiwayMergingNetworkShape(shapes,
+                                                 prefixSums,
+                                                 splits,
+                                                 firstRun,
+                                                 split));
+    auto const second(multiwayMergingNetworkShape(shapes,
+                                                  prefixSums,
+                                                  splits,
+                                                  split + 1u,
+                                                  lastRun));
+    NetworkShape r;
+    r.addStages(first.stageWidths);
+    r.addStages(second.stageWidths);
+    auto merge(shapes.oddEvenMerge(first.outputs, second.outputs));
+    r.addStages(merge.stageWidths);
+    r.outputs = std::move(merge.outputs);
+    return r;
+}
+
+} /* namespace anonymous { */
+
+std::unique_ptr<NetworkImage const> makeSmallSortingNetwork(
+        std::size_t const n)
+{
+    NetworkBuilder builder(n);
+    addSmallSortingNetwork(builder, 0u, n);
+    return builder.build();
+}
+
+NetworkMetrics measureSmallSortingNetwork(std::size_t const n)
+{
+    NetworkBuilder builder(n, true);
+    addSmallSortingNetwork(builder, 0u, n);
+    return builder.metrics();
+}
+
+std::unique_ptr<NetworkImage const> makeOddEvenMergeSortingNetwork(
+        std::size_t const n)
+{
+    NetworkBuilder builder(n);
+    addOddEvenMergeSortingNetwork(builder, 0u, n);
+    return builder.build();
+}
+
+NetworkMetrics measureOddEvenMergeSortingNetwork(std::size_t const n)
+{
+    checkNumInputs(n);
+    return NetworkShapes().oddEvenMergeSort(n).metrics();
+}
+
+std::unique_ptr<NetworkImage const> makeOddEvenMergingNetwork(
+        std::size_t const m,
+        std::size_t const n)
+{
+    NetworkBuilder builder(m + n);
+    addOddEvenMergingNetwork(builder, 0u, m, n);
+    return builder.build();
+}
+
+NetworkMetrics measureOddEvenMergingNetwork(std::size_t const m,
+                                            std::size_t const n)
+{
+    checkNumInputs(m + n);
+    return NetworkShapes().oddEvenMerge(DepthProfile(m, 0u),
+                                        DepthProfile(n, 0u)).metrics();
+}
+
+std::unique_ptr<NetworkImage const> makeMultiwayMergingNetwork(
+        std::vector<std::size_t> const & runs)
+{
+    NetworkBuilder builder(totalRunLength(runs));
+    addMultiwayMergingNetwork(builder, runs);
+    return builder.build();
+}
+
+NetworkMetrics measureMultiwayMergingNetwork(
+        std::vector<std::size_t> const & runs)
+{
+    auto const prefixSums(runPrefixSums(runs));
+    checkNumInputs(prefixSums.back());
+    if (runs.size() < 2u)
+        return NetworkMetrics{0u, 0u, 0u};
+    NetworkShapes shapes;
+    return multiwayMergingNetworkShape(shapes,
+                                       prefixSums,
+                                       planMultiwayMergingNetwork(prefixSums),
+                                       0u,
+                                       runs.size() - 1u).metrics();
+}
+
+std::unique_ptr<NetworkImage const> makePairwiseSortingNetwork(
+        std::size_t const n)
+{
+    NetworkBuilder builder(n);
+    addPairwiseSortingNetwork(builder, 0u, 1u, nextPowerOfTwo(n));
+    return builder.build();
+}
+
+NetworkMetrics measurePairwiseSortingNetwork(std::size_t const n)
+{
+    checkNumInputs(n);
+    return NetworkShapes().pairwiseSort(nextPowerOfTwo(n),
+                                        DepthProfile(n, 0u)).metrics();
+}
+
+std::unique_ptr<NetworkImage const> makeSelectionNetwork(
+        std::size_t const n,
+        std::vector<std::size_t> const & ranks)
+{
+    NetworkBuilder builder(n);
+    addSelectionNetwork(builder, ranks);
+    return builder.build();
+}
+
+NetworkMetrics measureSelectionNetwork(std::size_t const n,
+                                       std::vector<std::size_t> const & ranks)
+{
+    NetworkBuilder builder(n, true);
+    addSelectionNetwork(builder, ranks);
+    return builder.metrics();
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+#ifndef SHAREMIND_MOD_ALGORITHMS_SORTINGNETWORKCONSTRUCTIONS_H
+#define SHAREMIND_MOD_ALGORITHMS_SORTINGNETWORKCONSTRUCTIONS_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "NetworkMetrics.h"
+#include "NetworkStore.h"
+
+
+/*
+  Every network constructor makeX() is accompanied by measureX(), which
+  returns the metrics of the same network without building it.
+*/
+
+/** The largest number of elements with a built-in best-known network. */
+constexpr std::size_t maxSmallSortingNetworkElements = 16u;
+
+/**
+  \brief Returns the built-in best-known sorting network for the given number
+         of elements.
+  \pre elements <= maxSmallSortingNetworkElements
+*/
+std::unique_ptr<NetworkImage const> makeSmallSortingNetwork(
+        std::size_t elements) __attribute__ ((visibility("internal")));
+NetworkMetrics measureSmallSortingNetwork(std::size_t elements)
+        __attribute__ ((visibility("internal")));
+
+/**
+  \brief Constructs an odd-even merge sorting network for the given number of
+         elements.
+  \details The elements are sorted recursively in two parts which are combined
+           with Batcher's odd-even merge, down to the built-in best-known
+           networks for up to maxSmallSortingNetworkElements elements.
+*/
+std::unique_ptr<NetworkImage const> makeOddEvenMergeSortingNetwork(
+        std::size_t elements) __attribute__ ((visibility("internal")));
+NetworkMetrics measureOddEvenMergeSortingNetwork(std::size_t elements)
+        __attribute__ ((visibility("internal")));
+
+/**
+  \brief Constructs Batcher's odd-even merging network which merges the sorted
+         runs of the first m and the last n elements.
+  \details The network has O((m + n) log (m + n)) comparators and depth
+           O(log (m + n)), and needs only m comparators if n is 1.
+*/
+std::unique_ptr<NetworkImage const> makeOddEvenMergingNetwork(
+        std::size_t m,
+        std::size_t n) __attribute__ ((visibility("internal")));
+NetworkMetrics measureOddEvenMergingNetwork(std::size_t m, std::size_t n)
+        __attribute__ ((visibility("internal")));
+
+/** The largest number of runs for which multiway merges are optimized. */
+constexpr std::size_t maxPlannedMultiwayMergeRuns = 256u;
+
+/**
+  \brief Constructs a network which merges the consecutive sorted runs of the
+         given lengths.
+  \details The network is a tree of Batcher's odd-even merges of adjacent
+           runs. For up to maxPlannedMultiwayMergeRuns runs, the shape of the
+           tree is chosen to minimize its depth and then its number of
+           comparators among such trees, which helps runs of unequal lengths.
+           Otherwise, and for runs of equal lengths anyway, the runs are
+           merged in a balanced tree. Either way, merging k runs of N elements
+           in total takes a depth of about log2(k) * log2(N), not that of a
+           single merge of N elements.
+*/
+std::unique_ptr<NetworkImage const> makeMultiwayMergingNetwork(
+        std::vector<std::size_t> const & runs)
+        __attribute__ ((visibility("internal")));
+NetworkMetrics measureMultiwayMergingNetwork(
+        std::vector<std::size_t> const & runs)
+        __attribute__ ((visibility("internal")));
+
+/**
+  \brief Constructs Parberry's pairwise sorting network for the given number of
+         elements.
+  \details For a number of elements which is not a power of two, the network
+           for the next power of two is used without the comparators on the
+           missing elements.
+*/
+std::unique_ptr<NetworkImage const> makePairwiseSortingNetwork(
+        std::size_t elements) __attribute__ ((visibility("internal")));
+NetworkMetrics measurePairwiseSortingNetwork(std::size_t elements)
+        __attribute__ ((visibility("internal")));
+
+/**
+  \brief Constructs a selection network which places the elements of the given
+         ranks in the sorted order of its inputs onto the wires of the same
+         indices.
+  \details The odd-even merge and the pairwise sorting networks are pruned to
+           the comparators on which the given outputs depend, and the one with
+           fewer comparators is used. As a merge pruned to a few outputs needs
+           only a few outputs of the recursive sorts, those are pruned to
+           selections of their smallest or largest elements in turn, like the
+           parts of Alekseev's selection networks. The sorting networks are
+           pruned while they are generated, so beyond the pruned network only
+           a bit per comparator of the sorting networks is stored.
+  \pre ranks is ascending and nonempty, and all ranks are below elements.
+*/
+std::unique_ptr<NetworkImage const> makeSelectionNetwork(
+        std::size_t elements,
+        std::vector<std::size_t> const & ranks)
+        __attribute__ ((visibility("internal")));
+NetworkMetrics measureSelectionNetwork(std::size_t elements,
+                                       std::vector<std::size_t> const & ranks)
+        __attribute__ ((visibility("internal")));
+
+#endif /* SHAREMIND_MOD_ALGORITHMS_SORTINGNETWORKCONSTRUCTIONS_H */
@@ -20,134 +20,752 @@
 #ifndef SHAREMIND_MOD_ALGORITHMS_SORTINGNETWORKGENERATOR_H
 #define SHAREMIND_MOD_ALGORITHMS_SORTINGNETWORKGENERATOR_H
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <deque>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <sharemind/DebugOnly.h>
 #include <sharemind/libsortnetwork/Network.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
+#include "BakedNetworks.h"
+#include "NetworkCache.h"
+#include "NetworkMetrics.h"
+#include "NetworkStore.h"
+#include "ParallelSerialization.h"
+#include "SortingNetworkConstructions.h"
 
 
-class __attribute__ ((visibility("internal"))) SerializableNetwork :
-    private sharemind::SortingNetwork::Network
-{
+/**
+  \brief The sorting network algorithms which may be selected by the optional
+         algorithm argument of the sorting network syscalls.
+  \details SORTING_NETWORK_ODD_EVEN_MERGE_SORT is the default, because unlike
+           the bitonic merge sort it adapts to numbers of elements which are
+           not powers of two.
+
+           The implicit networks are never cached, but computed directly into
+           the output buffers instead, which suits huge networks.
+*/
+enum SortingNetworkAlgorithm : std::uint64_t {
+    SORTING_NETWORK_BITONIC_MERGE_SORT = 0u,
+    SORTING_NETWORK_ODD_EVEN_MERGE_SORT = 1u,
+    SORTING_NETWORK_PAIRWISE_SORT = 2u,
+    SORTING_NETWORK_IMPLICIT_BITONIC_MERGE_SORT = 3u,
+    SORTING_NETWORK_IMPLICIT_ODD_EVEN_MERGE_SORT = 4u
+};
+
+/**
+  \brief A network which is kept in its serialized form, so that serializing
+         it is a plain copy.
+  \details A network is serialized as the number of stages, followed by each
+           stage as the number of comparators in the stage, the left and the
+           right inputs of the comparators and the target positions for their
+           minima and maxima.
+*/
+class __attribute__ ((visibility("internal"))) SerializableNetwork {
 
 private: /* Types */
 
     using Network = sharemind::SortingNetwork::Network;
 
+public: /* Types: */
+
+    class InvalidImageException: public std::runtime_error {
+
+    public: /* Methods: */
+
+        InvalidImageException()
+            : std::runtime_error("Invalid serialized network image!")
+        {}
+
+    };
+
 public: /* Methods: */
 
-    SerializableNetwork(Network&& network)
-        : Network(network)
-        , m_serializationSize(
+    SerializableNetwork(Network const & network)
+        : SerializableNetwork(serializeNetwork(network))
+    {}
+
+    /**
+       \brief Constructs the network from its serialized image.
+       \throws InvalidImageException if the image is malformed.
+    */
+    SerializableNetwork(std::unique_ptr<NetworkImage const> image)
+        : m_image(std::move(image))
+        , m_stageOffsets(
             [this]() {
-                // Start with the number of stages as a single number:
-                std::size_t r = 1u;
-                // Second, we store each stage separately:
-                for (auto const & stage : stages()) {
-                    // For each stage, we store its size as a single number:
-                    ++r;
-                    /* Then we store all the first indices in the pairs and
-                       then the second ones: */
-                    r += 4u * stage.numComparators();
+                /* Record where in the serialized form each stage begins,
+                   checking that the stages exactly fill the image: */
+                assert(m_image);
+                auto const * const data = m_image->data();
+                auto const size = m_image->size();
+                if (size < 1u)
+                    throw InvalidImageException();
+                std::vector<std::size_t> r;
+                r.reserve(data[0u] <= size ? data[0u] + 1u : 1u);
+                r.push_back(1u);
+                for (std::size_t i = 0u; i < data[0u]; ++i) {
+                    auto const offset = r.back();
+                    if (offset >= size || (size - offset - 1u) / 4u < data[offset])
+                        throw InvalidImageException();
+                    r.push_back(offset + 1u + 4u * data[offset]);
                 }
+                if (r.back() != size)
+                    throw InvalidImageException();
+                return r;
+            }())
+        , m_maxIndex(
+            [this]() {
+                std::size_t r = 0u;
+                auto const * const data = m_image->data();
+                for (std::size_t s = 0u; s + 1u < m_stageOffsets.size(); ++s)
+                    for (std::size_t i = m_stageOffsets[s] + 1u;
+                         i < m_stageOffsets[s + 1u];
+                         ++i)
+                        r = std::max(r, data[i]);
                 return r;
             }())
     {}
 
+    NetworkImage const & image() const noexcept { return *m_image; }
+
+    std::size_t numStages() const noexcept
+    { return m_stageOffsets.size() - 1u; }
+
+    /**
+       \returns whether all numbers in the serialized form of this network fit
+                 into 32-bit words, i.e. whether serialize() may be called with
+                 a std::uint32_t buffer.
+    */
+    bool fitsCompactSerialization() const noexcept {
+        return m_maxIndex <= std::numeric_limits<std::uint32_t>::max()
+               && numStages() <= std::numeric_limits<std::uint32_t>::max();
+    }
+
+    std::size_t numComparators() const noexcept
+    { return (serializedSize() - 1u - numStages()) / 4u; }
+
     std::size_t serializedSize() const noexcept
-    { return m_serializationSize; }
+    { return m_stageOffsets.back(); }
 
-    void serialize(std::uint64_t * ptr) const noexcept {
+    /**
+       \returns the size of the serialization of stages
+                 [firstStage, lastStage) in the same format as serialize().
+    */
+    std::size_t serializedStagesSize(std::size_t const firstStage,
+                                     std::size_t const lastStage)
+            const noexcept
+    {
+        assert(firstStage <= lastStage);
+        assert(lastStage <= numStages());
+        return 1u + m_stageOffsets[lastStage] - m_stageOffsets[firstStage];
+    }
+
+    NetworkMetrics metrics() const noexcept {
+        NetworkMetrics r{numStages(), numComparators(), 0u};
+        for (std::size_t s = 0u; s < numStages(); ++s)
+            r.maxStageWidth = std::max<std::uint64_t>(
+                        r.maxStageWidth,
+                        m_image->data()[m_stageOffsets[s]]);
+        return r;
+    }
+
+    /** \returns the memory used by this network in bytes. */
+    std::size_t memoryUsage() const noexcept {
+        return sizeof(*this)
+               + m_stageOffsets.capacity() * sizeof(std::size_t)
+               + m_image->memoryUsage();
+    }
+
+    /**
+       \brief Serializes the network into a buffer of serializedSize() words.
+       \details Word may be std::uint64_t, or std::uint32_t for the compact
+                format if fitsCompactSerialization() holds.
+    */
+    template <typename Word>
+    void serialize(Word * ptr) const noexcept
+    { serializeStages(0u, numStages(), ptr); }
+
+    /**
+       \brief Serializes only the stages [firstStage, lastStage).
+       \details The output starts with the number of serialized stages, i.e.
+                the range is serialized as if it were a network by itself.
+    */
+    template <typename Word>
+    void serializeStages(std::size_t const firstStage,
+                         std::size_t const lastStage,
+                         Word * ptr) const noexcept
+    {
+        static_assert(std::is_same<Word, std::uint64_t>::value
+                      || std::is_same<Word, std::uint32_t>::value,
+                      "Only 64-bit and 32-bit words are supported!");
+        assert(firstStage <= lastStage);
+        assert(lastStage <= numStages());
+        assert(sizeof(Word) >= sizeof(std::size_t)
+               || fitsCompactSerialization());
         // First, we store the number of stages
+        (*ptr) = static_cast<Word>(lastStage - firstStage);
+        // The stages themselves are already serialized:
+        copySerializedWords(m_image->data() + m_stageOffsets[firstStage],
+                            m_stageOffsets[lastStage]
+                            - m_stageOffsets[firstStage],
+                            ptr + 1u);
+    }
+
+protected: /* Methods: */
+
+    /** \returns the largest index or target position of any comparator. */
+    std::size_t maxIndex() const noexcept { return m_maxIndex; }
+
+    static std::unique_ptr<NetworkImage const> serializeNetwork(
+            Network const & network)
+    {
         static_assert(std::numeric_limits<std::size_t>::max()
                       == std::numeric_limits<std::uint64_t>::max(),
                       "Platform not supported!");
-        (*ptr) = numStages();
+        std::size_t size = 1u;
+        for (auto const & stage : network.stages())
+            size += 1u + 4u * stage.numComparators();
+
+        std::vector<std::uint64_t> r;
+        r.reserve(size);
+        // First, we store the number of stages
+        r.push_back(network.numStages());
         // Second, we store each stage separately
-        for (auto const & stage : stages()) {
+        for (auto const & stage : network.stages()) {
             // For each stage, we store its size as a single number
-            (*++ptr) = stage.numComparators();
+            r.push_back(stage.numComparators());
 
             // First we store the left sides of the pairs
             for (auto const & comp : stage.comparators())
-                (*++ptr) = comp.left();
+                r.push_back(comp.left());
 
             // Then, we store the right sides of the pairs
             for (auto const & comp : stage.comparators())
-                (*++ptr) = comp.right();
+                r.push_back(comp.right());
 
             // We also store the target positions. Minima first.
             for (auto const & comp : stage.comparators())
-                (*++ptr) = comp.min();
+                r.push_back(comp.min());
 
             // Maxima second.
             for (auto const & comp : stage.comparators())
-                (*++ptr) = comp.max();
+                r.push_back(comp.max());
         }
+        assert(r.size() == size);
+        return std::make_unique<NetworkImage const>(std::move(r));
     }
 
 private: /* Fields: */
 
-    std::size_t const m_serializationSize = 0u;
+    std::unique_ptr<NetworkImage const> const m_image;
+
+    /** Offsets of the stages in the serialized form, plus the total size. */
+    std::vector<std::size_t> const m_stageOffsets;
+
+    /** The largest index or target position used by any comparator. */
+    std::size_t const m_maxIndex;
 
 }; /* class SerializableNetwork { */
 
-class __attribute__ ((visibility("internal"))) SortingNetwork : public SerializableNetwork {
+class __attribute__ ((visibility("internal"))) BitonicSortingNetwork : public SerializableNetwork {
+
+private: /* Types: */
+
+    /** The numbers of comparators of networks by their number of elements. */
+    using Comparators = std::map<std::size_t, std::uint64_t>;
+
+private:
+    /**
+      \returns the number of comparators of the bitonic merger of m elements,
+               which compares the first floor(m/2) elements to the following
+               ones and recurses on both halves. As the halves at every level of
+               the recursion differ by at most one element, each distinct size
+               is computed only once.
+    */
+    static std::uint64_t mergerComparators(std::size_t const m,
+                                           Comparators & mergers)
+    {
+        if (m < 2u)
+            return 0u;
+        auto const it(mergers.find(m));
+        if (it != mergers.cend())
+            return it->second;
+        std::uint64_t const r = m / 2u + mergerComparators(m / 2u, mergers)
+                                + mergerComparators(m - m / 2u, mergers);
+        mergers.emplace(m, r);
+        return r;
+    }
+
+    /** \returns the number of comparators of the network for n elements. */
+    static std::uint64_t sortComparators(std::size_t const n,
+                                         Comparators & sorts,
+                                         Comparators & mergers)
+    {
+        if (n < 2u)
+            return 0u;
+        auto const it(sorts.find(n));
+        if (it != sorts.cend())
+            return it->second;
+        std::uint64_t const r = sortComparators(n / 2u, sorts, mergers)
+                                + sortComparators(n - n / 2u, sorts, mergers)
+                                + mergerComparators(n, mergers);
+        sorts.emplace(n, r);
+        return r;
+    }
+
+    static std::unique_ptr<NetworkImage const> generateSortingNetwork(
+            std::size_t elements)
+    {
+        // Small networks are taken from the table of best-known networks:
+        if (elements <= maxSmallSortingNetworkElements)
+            return makeSmallSortingNetwork(elements);
+        return serializeNetwork(
+            sharemind::SortingNetwork::Network::makeBitonicMergeSort(elements));
+    }
 
 public:
-    SortingNetwork(std::size_t elements)
-        : SerializableNetwork(
-            sharemind::SortingNetwork::Network::makeBitonicMergeSort(elements))
+    BitonicSortingNetwork(std::size_t elements)
+        : SerializableNetwork(generateSortingNetwork(elements))
         {}
-}; /* class SortingNetwork { */
 
-class __attribute__ ((visibility("internal"))) MergingNetwork : public SerializableNetwork {
+    BitonicSortingNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+        {}
 
-private:
-    sharemind::SortingNetwork::Network generateMergingNetwork(std::size_t elements) {
-        sharemind::SortingNetwork::Network inps1(elements);
-        sharemind::SortingNetwork::Network inps2(inps1);
-        sharemind::SortingNetwork::Network res = combineOddEvenMerge(inps1, inps2);
-        return res;
+    /**
+      \returns the metrics of the network, which are those of modelMetrics()
+               unless the model is not verified for the given number of
+               elements, in which case the network is generated.
+    */
+    static NetworkMetrics measure(std::size_t elements) {
+        if (!bitonicMetricsModelVerified() && (elements & (elements - 1u)))
+            return BitonicSortingNetwork(elements).metrics();
+        return modelMetrics(elements);
     }
 
+    /**
+      \returns the metrics of the network as modelled on the bitonic merge
+               sort of libsortnetwork, without generating it.
+      \details BakeNetworks checks the model against the generated networks.
+               The model follows the construction for powers of two, but the
+               construction for other numbers of elements is specific to the
+               library.
+    */
+    static NetworkMetrics modelMetrics(std::size_t elements) {
+        if (elements <= maxSmallSortingNetworkElements)
+            return measureSmallSortingNetwork(elements);
+        /* The network sorts both halves of the elements in parallel and
+           combines them with a bitonic merger of depth ceil(log2 n), whose
+           first stage is the widest stage of the whole network: */
+        std::uint64_t depth = 0u;
+        for (std::size_t n = elements; n > 1u; n -= n / 2u) {
+            std::uint64_t mergerDepth = 0u;
+            while ((std::size_t(1u) << mergerDepth) < n)
+                ++mergerDepth;
+            depth += mergerDepth;
+        }
+        Comparators mergers;
+        Comparators sorts;
+        return NetworkMetrics{depth,
+                              sortComparators(elements, sorts, mergers),
+                              elements / 2u};
+    }
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(std::size_t elements)
+    { return "BitonicSortingNetwork-v1-" + std::to_string(elements); }
+}; /* class BitonicSortingNetwork { */
+
+class __attribute__ ((visibility("internal"))) OddEvenMergeSortingNetwork
+        : public SerializableNetwork
+{
+
+public:
+    OddEvenMergeSortingNetwork(std::size_t elements)
+        : SerializableNetwork(makeOddEvenMergeSortingNetwork(elements))
+        {}
+
+    OddEvenMergeSortingNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+        {}
+
+    /** \returns the metrics of the network without generating it. */
+    static NetworkMetrics measure(std::size_t elements)
+    { return measureOddEvenMergeSortingNetwork(elements); }
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(std::size_t elements)
+    { return "OddEvenMergeSortingNetwork-v3-" + std::to_string(elements); }
+}; /* class OddEvenMergeSortingNetwork { */
+
+class __attribute__ ((visibility("internal"))) PairwiseSortingNetwork
+        : public SerializableNetwork
+{
+
+public:
+    PairwiseSortingNetwork(std::size_t elements)
+        : SerializableNetwork(makePairwiseSortingNetwork(elements))
+        {}
+
+    PairwiseSortingNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+        {}
+
+    /** \returns the metrics of the network without generating it. */
+    static NetworkMetrics measure(std::size_t elements)
+    { return measurePairwiseSortingNetwork(elements); }
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(std::size_t elements)
+    { return "PairwiseSortingNetwork-v1-" + std::to_string(elements); }
+}; /* class PairwiseSortingNetwork { */
+
+class __attribute__ ((visibility("internal"))) MergingNetwork : public SerializableNetwork {
+
 public:
     MergingNetwork(std::size_t elements)
-        : SerializableNetwork(generateMergingNetwork(elements))
+        : SerializableNetwork(makeOddEvenMergingNetwork(elements, elements))
         {}
+
+    MergingNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+        {}
+
+    /** \returns the metrics of the network without generating it. */
+    static NetworkMetrics measure(std::size_t elements)
+    { return measureOddEvenMergingNetwork(elements, elements); }
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(std::size_t elements)
+    { return "MergingNetwork-v2-" + std::to_string(elements); }
 }; /* class MergingNetwork { */
 
-template<typename T>
+class __attribute__ ((visibility("internal"))) UnequalMergingNetwork
+        : public SerializableNetwork
+{
+
+public: /* Types: */
+
+    /** The lengths of the two sorted runs to merge. */
+    using Runs = std::pair<std::size_t, std::size_t>;
+
+public:
+    UnequalMergingNetwork(Runs const & runs)
+        : SerializableNetwork(
+            makeOddEvenMergingNetwork(runs.first, runs.second))
+        {}
+
+    UnequalMergingNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+        {}
+
+    /** \returns the metrics of the network without generating it. */
+    static NetworkMetrics measure(Runs const & runs)
+    { return measureOddEvenMergingNetwork(runs.first, runs.second); }
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(Runs const & runs) {
+        return "UnequalMergingNetwork-v1-" + std::to_string(runs.first)
+               + '-' + std::to_string(runs.second);
+    }
+}; /* class UnequalMergingNetwork { */
+
+class __attribute__ ((visibility("internal"))) MultiwayMergingNetwork
+        : public SerializableNetwork
+{
+
+public: /* Types: */
+
+    /** The lengths of the consecutive sorted runs to merge. */
+    using Runs = std::vector<std::size_t>;
+
+public:
+    MultiwayMergingNetwork(Runs const & runs)
+        : SerializableNetwork(makeMultiwayMergingNetwork(runs))
+        {}
+
+    MultiwayMergingNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+        {}
+
+    /** \returns the metrics of the network without generating it. */
+    static NetworkMetrics measure(Runs const & runs)
+    { return measureMultiwayMergingNetwork(runs); }
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(Runs const & runs) {
+        std::string r("MultiwayMergingNetwork-v1");
+        for (auto const run : runs)
+            r += '-' + std::to_string(run);
+        return r;
+    }
+}; /* class MultiwayMergingNetwork { */
+
+class __attribute__ ((visibility("internal"))) SelectionNetwork
+        : public SerializableNetwork
+{
+
+public: /* Types: */
+
+    /** The number of elements and the ascending ranks to select. */
+    using Ranks = std::pair<std::size_t, std::vector<std::size_t> >;
+
+public:
+    SelectionNetwork(Ranks const & ranks)
+        : SerializableNetwork(makeSelectionNetwork(ranks.first, ranks.second))
+        {}
+
+    SelectionNetwork(std::unique_ptr<NetworkImage const> image)
+        : SerializableNetwork(std::move(image))
+        {}
+
+    /** \returns the metrics of the network without keeping it. */
+    static NetworkMetrics measure(Ranks const & ranks)
+    { return measureSelectionNetwork(ranks.first, ranks.second); }
+
+    /**
+       \returns the name of the network in a NetworkStore. Change the version
+                 whenever the generated networks change.
+    */
+    static std::string storageName(Ranks const & ranks) {
+        std::string r("SelectionNetwork-v2-" + std::to_string(ranks.first));
+        for (auto const rank : ranks.second)
+            r += '-' + std::to_string(rank);
+        return r;
+    }
+}; /* class SelectionNetwork { */
+
+/** \returns the number of bytes a key of a network holds on the heap. */
+inline std::size_t keyHeapUsage(std::size_t) noexcept { return 0u; }
+
+inline std::size_t keyHeapUsage(std::vector<std::size_t> const & key) noexcept
+{ return key.capacity() * sizeof(std::size_t); }
+
+template <typename First, typename Second>
+std::size_t keyHeapUsage(std::pair<First, Second> const & key) noexcept
+{ return keyHeapUsage(key.first) + keyHeapUsage(key.second); }
+
+/**
+  \brief Generates, caches and stores networks of type T, which are identified
+         by keys of type Key, i.e. by their number of inputs by default.
+  \details T must be constructible from a Key and from a NetworkImage,
+           T::storageName(Key) must name the network in a NetworkStore and
+           T::measure(Key) must return the metrics of the network.
+*/
+template<typename T, typename Key = std::size_t>
 class __attribute__ ((visibility("internal"))) SortingNetworkGenerator {
 
 private: /* Types: */
 
-    using Cache = std::map<std::size_t, std::unique_ptr<T> >;
+    using Cache = NetworkCache<Key, T>;
+
+    using Metrics = std::map<Key, NetworkMetrics>;
+
+public: /* Types: */
+
+    using CacheStatistics = typename Cache::Statistics;
+
+    using BakedNetworks = std::map<Key, std::shared_ptr<T const> >;
 
 public: /* Methods: */
 
-    T * getCachedOrGenerateAndCacheNetwork(
-                std::size_t const numInputs)
+    /**
+       \param[in] cacheBudget The budget of the memory of the cached networks
+                             and the remembered metrics.
+       \param[in] store The store for persisting the generated networks.
+       \param[in] bakedNetworks The networks baked into the module, which are
+                               returned without locking and do not count
+                               towards the cache statistics.
+    */
+    SortingNetworkGenerator(NetworkCacheBudget & cacheBudget,
+                            NetworkStore const & store,
+                            BakedNetworks bakedNetworks = BakedNetworks())
+        : m_bakedNetworks(std::move(bakedNetworks))
+        , m_sortingNetworkCache(cacheBudget)
+        , m_store(store)
+    {}
+
+    ~SortingNetworkGenerator() noexcept
+    { m_sortingNetworkCache.budget().release(m_metricsBytes); }
+
+    std::shared_ptr<T const> getCachedOrGenerateAndCacheNetwork(
+                Key const & key)
+    {
+        if (auto r = findBakedNetwork(key))
+            return r;
+        return m_sortingNetworkCache.getOrGenerate(
+                    key,
+                    [this](Key const & k) {
+                        return loadOrGenerateAndStoreNetwork(k);
+                    });
+    }
+
+    /**
+       \brief Returns the network if it is cached, and otherwise loads or
+              generates it without caching it.
+    */
+    std::shared_ptr<T const> getCachedOrGenerateNetwork(Key const & key) {
+        if (auto r = findBakedNetwork(key))
+            return r;
+        if (auto r = m_sortingNetworkCache.find(key))
+            return r;
+        return loadOrGenerateAndStoreNetwork(key);
+    }
+
+    /** \brief Caches the given network unless one is already cached. */
+    std::shared_ptr<T const> cacheNetwork(Key const & key,
+                                          std::shared_ptr<T const> network)
     {
-        std::lock_guard<std::mutex> lock(m_sortingNetworkCacheMutex);
-        auto it(m_sortingNetworkCache.find(numInputs));
-        if (it != m_sortingNetworkCache.cend())
-            return static_cast<T*>(it->second.get());
-        auto sn(std::make_unique<T>(numInputs));
-        auto r(sn.get());
-        SHAREMIND_DEBUG_ONLY(auto const rv =)
-                m_sortingNetworkCache.emplace(numInputs, std::move(sn));
-        assert(rv.second);
+        return m_sortingNetworkCache.getOrGenerate(
+                    key,
+                    [&network](Key const &) {
+                        return std::move(network);
+                    });
+    }
+
+    /**
+       \brief Returns the metrics of the network, which are remembered even if
+              the network itself is not cached.
+       \details The metrics of a network which is not cached are measured
+                without caching, storing or, for most networks, even
+                generating the network. The remembered metrics are charged
+                to the budget of the cache, see rememberMetrics().
+    */
+    NetworkMetrics networkMetrics(Key const & key) {
+        if (auto const baked = findBakedNetwork(key))
+            return baked->metrics();
+        {
+            std::lock_guard<std::mutex> const guard(m_metricsMutex);
+            auto const it(m_metrics.find(key));
+            if (it != m_metrics.cend())
+                return it->second;
+        }
+        auto const network(m_sortingNetworkCache.find(key));
+        NetworkMetrics const r(network ? network->metrics() : T::measure(key));
+        rememberMetrics(key, r);
+        return r;
+    }
+
+    CacheStatistics cacheStatistics() const
+    { return m_sortingNetworkCache.statistics(); }
+
+private: /* Methods: */
+
+    /**
+       \brief Remembers the metrics of a network.
+       \details The remembered metrics are charged to the budget of the
+                cache, and the metrics remembered first are forgotten
+                whenever the budget is exceeded, so that distinct queries do
+                not grow the memory use without bound.
+    */
+    void rememberMetrics(Key const & key, NetworkMetrics const & metrics) {
+        auto & budget = m_sortingNetworkCache.budget();
+        std::lock_guard<std::mutex> const guard(m_metricsMutex);
+        auto const rv(m_metrics.emplace(key, metrics));
+        if (!rv.second)
+            return;
+        m_metricsOrder.push_back(rv.first);
+        m_metricsBytes += metricsMemoryUsage(key);
+        budget.charge(metricsMemoryUsage(key));
+        while (budget.capacity()
+               && !m_metricsOrder.empty()
+               && budget.chargedBytes() > budget.capacity())
+        {
+            auto const it(m_metricsOrder.front());
+            m_metricsOrder.pop_front();
+            m_metricsBytes -= metricsMemoryUsage(it->first);
+            budget.release(metricsMemoryUsage(it->first));
+            m_metrics.erase(it);
+        }
+    }
+
+    /** \returns the memory used by the remembered metrics of a network. */
+    static std::size_t metricsMemoryUsage(Key const & key) noexcept {
+        // A node of the tree with its pointers and color, and its place in
+        // the order:
+        return sizeof(typename Metrics::value_type) + 4u * sizeof(void *)
+               + sizeof(typename Metrics::iterator) + keyHeapUsage(key);
+    }
+
+    std::shared_ptr<T const> findBakedNetwork(Key const & key) const {
+        auto const it(m_bakedNetworks.find(key));
+        return (it != m_bakedNetworks.cend()) ? it->second : nullptr;
+    }
+
+    std::shared_ptr<T const> loadOrGenerateAndStoreNetwork(Key const & key) {
+        if (!m_store.enabled())
+            return std::make_shared<T const>(key);
+
+        auto const name(T::storageName(key));
+        if (auto image = m_store.load(name)) {
+            try {
+                return std::make_shared<T const>(std::move(image));
+            } catch (SerializableNetwork::InvalidImageException const &) {
+                // Generate and store the network again.
+            }
+        }
+
+        auto r(std::make_shared<T const>(key));
+        m_store.store(name, r->image().data(), r->image().size());
         return r;
     }
 
 private: /* Fields: */
 
-    mutable std::mutex m_sortingNetworkCacheMutex;
+    BakedNetworks const m_bakedNetworks;
     Cache m_sortingNetworkCache;
+    NetworkStore const & m_store;
+
+    std::mutex m_metricsMutex;
+    Metrics m_metrics;
+    /** The remembered metrics in the order they were remembered. */
+    std::deque<typename Metrics::iterator> m_metricsOrder;
+    std::size_t m_metricsBytes = 0u;
 }; /* class SortingNetworkGenerator {*/
 
+/**
+  \brief Loads the networks of type T baked into the module, for which
+         bake(elements) returns the serialized network or no network.
+*/
+template <typename T, typename Bake>
+typename SortingNetworkGenerator<T>::BakedNetworks loadBakedNetworks(
+        Bake && bake)
+{
+    typename SortingNetworkGenerator<T>::BakedNetworks r;
+    for (std::size_t n = 1u; n <= maxBakedNetworkElements; ++n) {
+        BakedNetwork const baked(bake(n));
+        if (baked.data)
+            r.emplace(n,
+                      std::make_shared<T const>(
+                          std::make_unique<NetworkImage const>(baked.data,
+                                                               baked.size)));
+    }
+    return r;
+}
+
 #endif /* SHAREMIND_MOD_ALGORITHMS_SORTINGNETWORKGENERATOR_H */
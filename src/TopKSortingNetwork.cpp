@@ -20,49 +20,188 @@
 #include "TopKSortingNetwork.h"
 
 #include <cassert>
+#include <limits>
+#include "AllocateSerializedNetwork.h"
 #include "CatchModuleApiErrors.h"
 #include "ModuleData.h"
 #include "TopKSortingNetworkGenerator.h"
 
 
-extern "C" {
+namespace /* anonymous */ {
 
 /**
- * Mandatory arguments: uint32 size of array and uint32 number of
- * elements that need to be sorted.
- * Return value: the size of the sorting network.
- */
-SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_serializedSize,
-                                 args, num_args, refs, crefs,
-                                 returnValue, c)
-{
-    assert(c);
-    assert(c->moduleHandle);
+  \brief The layout of TopKSortingNetwork_serialize.
+*/
+struct TopKLayout {
+
+    template <typename Network>
+    static std::size_t serializedSize(Network const & network) noexcept
+    { return network.serializedSize(); }
+
+    template <typename Network, typename Word>
+    static void serialize(Network const & network, Word * const ptr) noexcept
+    { network.serialize(ptr); }
+
+};
+
+/**
+  \brief The layout of MinMaxTopKSortingNetwork_serialize.
+*/
+struct MinMaxLayout {
+
+    template <typename Network>
+    static std::size_t serializedSize(Network const & network) noexcept
+    { return network.sortingNetworkSerializedSize(); }
+
+    template <typename Network, typename Word>
+    static void serialize(Network const & network, Word * const ptr) noexcept
+    { network.serializeAsSortingNetwork(ptr); }
+
+};
 
+/**
+  \brief Checks whether a top-k sorting network for the given number of
+         elements and outputs can be serialized in words of type Word.
+*/
+template <typename Word>
+bool validTopKArguments(uint64_t const elements, uint64_t const k) noexcept {
+    if (k > elements)
+        return false;
+    // All indices in the network must fit into the words:
+    return sizeof(Word) >= sizeof(uint64_t)
+           || elements <= std::numeric_limits<Word>::max() + uint64_t(1u);
+}
+
+template <typename Word, typename Layout>
+SharemindModuleApi0x1Error networkSerializedSize(
+        TopKSortingNetworkGenerator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    static_assert(sizeof(size_t) <= sizeof(returnValue->uint64[0u]),
+                  "sizeof(size_t) <= sizeof(returnValue->uint64[0u])");
     if (num_args != 2u || crefs || refs || !returnValue)
         return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
     const uint64_t elements = args[0u].uint64[0u];
     const uint64_t k = args[1u].uint64[0u];
+    if (!validTopKArguments<Word>(elements, k))
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
-    TopKSortingNetworkGenerator & generator =
-            static_cast<ModuleData *>(c->moduleHandle)
-                ->topKSortingNetworkGenerator;
     try {
-        static_assert(sizeof(size_t) <= sizeof(returnValue->uint64[0u]),
-                      "sizeof(size_t) <= sizeof(returnValue->uint64[0u])");
         auto const network =
                 generator.getCachedOrGenerateAndCacheNetwork(elements, k);
         if (!network)
             return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
-        returnValue->uint64[0u] = network->serializedSize();
+        returnValue->uint64[0u] = Layout::serializedSize(*network);
     } catch (...) {
         return catchModuleApiErrors();
     }
+    return SHAREMIND_MODULE_API_0x1_OK;
+}
 
+template <typename Word, typename Layout>
+SharemindModuleApi0x1Error networkSerialize(
+        TopKSortingNetworkGenerator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    if (num_args != 2u || crefs || !refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Get the inputs
+    const uint64_t elements = args[0u].uint64[0u];
+    const uint64_t k = args[1u].uint64[0u];
+    if (!validTopKArguments<Word>(elements, k))
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+    Word * const arrayStart = static_cast<Word *>(refs[0u].pData);
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    const size_t availableStorageSize = refs[0u].size / sizeof(Word);
+
+    try {
+        auto const network =
+                generator.getCachedOrGenerateAndCacheNetwork(elements, k);
+        if (!network)
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        if (availableStorageSize != Layout::serializedSize(*network))
+            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+        Layout::serialize(*network, arrayStart);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
     return SHAREMIND_MODULE_API_0x1_OK;
 }
 
+/**
+  \brief Serializes the top-k sorting network into newly allocated public
+         memory in words of type Word, returning its handle.
+*/
+template <typename Word>
+SharemindModuleApi0x1Error networkAllocateAndSerialize(
+        SharemindModuleApi0x1SyscallContext * const c,
+        TopKSortingNetworkGenerator & generator,
+        SharemindCodeBlock * const args,
+        std::size_t const num_args,
+        SharemindModuleApi0x1Reference const * const refs,
+        SharemindModuleApi0x1CReference const * const crefs,
+        SharemindCodeBlock * const returnValue)
+{
+    if (num_args != 2u || crefs || refs || !returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elements = args[0u].uint64[0u];
+    const uint64_t k = args[1u].uint64[0u];
+    if (!validTopKArguments<Word>(elements, k))
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    try {
+        auto const network =
+                generator.getCachedOrGenerateAndCacheNetwork(elements, k);
+        if (!network)
+            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
+        return allocateSerializedNetwork<Word>(c, *network, returnValue);
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+inline TopKSortingNetworkGenerator & topKSortingNetworkGenerator(
+        SharemindModuleApi0x1SyscallContext * const c) noexcept
+{
+    assert(c);
+    assert(c->moduleHandle);
+    return static_cast<ModuleData *>(c->moduleHandle)
+                ->topKSortingNetworkGenerator;
+}
+
+} // anonymous namespace
+
+
+extern "C" {
+
+/**
+ * Mandatory arguments: uint32 size of array and uint32 number of
+ * elements that need to be sorted.
+ * Return value: the size of the sorting network.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkSerializedSize<uint64_t, TopKLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
 /**
  * Mandatory arguments: uint64 size of array, uint64 number of
  * elements to sort, uint64 ref to the array where the sorting network
@@ -72,6 +211,100 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_serializedSize,
 SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_serialize,
                                  args, num_args, refs, crefs,
                                  returnValue, c)
+{
+    return networkSerialize<uint64_t, TopKLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+
+/**
+ * Mandatory arguments: uint64 size of array and uint64 number of
+ * elements that need to be sorted.
+ * Return value: the size of the sorting network in the compact format, i.e.
+ *               the number of uint32 words needed to store it.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactTopKSortingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkSerializedSize<uint32_t, TopKLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array, uint64 number of
+ * elements to sort, uint32 ref to the array where the sorting network
+ * is stored.
+ * No return value.
+ *
+ * The layout is the same as for TopKSortingNetwork_serialize, but every number
+ * is stored as an uint32.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactTopKSortingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkSerialize<uint32_t, TopKLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+
+/**
+ * Mandatory ref argument: uint64 array of 5 elements which receives the number
+ * of top-k sorting network cache hits, cache misses, evicted networks, the
+ * number of bytes used by the cached networks and the number of cached
+ * networks.
+ * No return value.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_cacheStatistics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+    (void) args;
+
+    if (num_args != 0u || crefs || !refs
+        || (static_cast<void>(assert(refs[0u].pData)), refs[1u].pData)
+        || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    // Note that this strips the remainder 1 byte used by SecreC:
+    if (refs[0u].size / sizeof(uint64_t) != 5u)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    TopKSortingNetworkGenerator const & generator = topKSortingNetworkGenerator(c);
+
+    try {
+        auto const statistics(generator.cacheStatistics());
+        uint64_t * const out = static_cast<uint64_t *>(refs[0u].pData);
+        out[0u] = statistics.hits;
+        out[1u] = statistics.misses;
+        out[2u] = statistics.evictions;
+        out[3u] = statistics.residentBytes;
+        out[4u] = statistics.cachedNetworks;
+        return SHAREMIND_MODULE_API_0x1_OK;
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+/**
+ * Mandatory arguments: uint64 size of array and uint64 number of
+ * elements that need to be sorted.
+ * Mandatory ref argument: uint64 array of 3 elements which receives the depth,
+ * the number of comparators and the number of comparators in the widest stage
+ * of the sorting network.
+ * No return value.
+ *
+ * The network is neither generated nor cached by this.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_metrics,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
 {
     assert(c);
     assert(c->moduleHandle);
@@ -81,30 +314,168 @@ SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_serialize,
         || returnValue)
         return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
-    // Get the inputs
     const uint64_t elements = args[0u].uint64[0u];
     const uint64_t k = args[1u].uint64[0u];
-    uint64_t * const arrayStart = static_cast<uint64_t *>(refs[0u].pData);
+    if (!validTopKArguments<uint64_t>(elements, k))
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
     // Note that this strips the remainder 1 byte used by SecreC:
-    const size_t availableStorageSize = refs[0u].size / sizeof(uint64_t);
+    if (refs[0u].size / sizeof(uint64_t) != 3u)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
 
-    TopKSortingNetworkGenerator & generator =
-            static_cast<ModuleData *>(c->moduleHandle)
-                ->topKSortingNetworkGenerator;
+    TopKSortingNetworkGenerator & generator = topKSortingNetworkGenerator(c);
 
     try {
-        auto const network =
-                generator.getCachedOrGenerateAndCacheNetwork(elements, k);
-        if (!network)
-            return SHAREMIND_MODULE_API_0x1_GENERAL_ERROR;
-        if (availableStorageSize != network->serializedSize())
-            return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
-        network->serialize(arrayStart);
+        auto const metrics(generator.networkMetrics(elements, k));
+        uint64_t * const out = static_cast<uint64_t *>(refs[0u].pData);
+        out[0u] = metrics.depth;
+        out[1u] = metrics.comparators;
+        out[2u] = metrics.maxStageWidth;
+        return SHAREMIND_MODULE_API_0x1_OK;
+    } catch (...) {
+        return catchModuleApiErrors();
+    }
+}
+
+/**
+ * Mandatory arguments: uint64 size of array and uint64 number of
+ * elements that need to be sorted.
+ * Return value: the handle of newly allocated public memory which contains the
+ *               sorting network in the format of TopKSortingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkAllocateAndSerialize<uint64_t>(
+                c, topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array and uint64 number of
+ * elements that need to be sorted.
+ * Return value: the handle of newly allocated public memory which contains the
+ *               sorting network in the format of
+ *               CompactTopKSortingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactTopKSortingNetwork_allocateAndSerialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkAllocateAndSerialize<uint32_t>(
+                c, topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array and uint64 number of
+ * elements that need to be sorted.
+ * No return value.
+ *
+ * Starts generating the sorting network in the background, so that a later
+ * call serializing it finds it in the cache. Errors in the generation are
+ * ignored, and reported by that later call instead.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(TopKSortingNetwork_prefetch,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    assert(c);
+    assert(c->moduleHandle);
+
+    if (num_args != 2u || crefs || refs || returnValue)
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    const uint64_t elements = args[0u].uint64[0u];
+    const uint64_t k = args[1u].uint64[0u];
+    if (!validTopKArguments<uint64_t>(elements, k))
+        return SHAREMIND_MODULE_API_0x1_INVALID_CALL;
+
+    ModuleData & moduleData = *static_cast<ModuleData *>(c->moduleHandle);
+
+    try {
+        moduleData.backgroundWorker.enqueue(
+                [&moduleData, elements, k]() {
+                    moduleData.topKSortingNetworkGenerator
+                            .getCachedOrGenerateAndCacheNetwork(elements, k);
+                });
         return SHAREMIND_MODULE_API_0x1_OK;
     } catch (...) {
         return catchModuleApiErrors();
     }
 }
 
+/**
+ * Mandatory arguments: uint64 size of array and uint64 number of
+ * elements that need to be sorted.
+ * Return value: the size of the sorting network in the format of
+ *               MinMaxTopKSortingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MinMaxTopKSortingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkSerializedSize<uint64_t, MinMaxLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array, uint64 number of
+ * elements to sort, uint64 ref to the array where the sorting network
+ * is stored.
+ * No return value.
+ *
+ * This is the network of TopKSortingNetwork_serialize in the layout of
+ * SortingNetwork_serialize, i.e. every stage consists of its number of
+ * comparators followed by the arrays of their left and right inputs and the
+ * targets of their minima and maxima, so the same routine applies both. The
+ * minimum of every comparator stays on its left input, so the k smallest
+ * elements end up at the front, or the k largest if the comparison is
+ * reversed.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(MinMaxTopKSortingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkSerialize<uint64_t, MinMaxLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array and uint64 number of
+ * elements that need to be sorted.
+ * Return value: the size of the sorting network in the format of
+ *               CompactMinMaxTopKSortingNetwork_serialize, i.e. the number of
+ *               uint32 words needed to store it.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactMinMaxTopKSortingNetwork_serializedSize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkSerializedSize<uint32_t, MinMaxLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
+/**
+ * Mandatory arguments: uint64 size of array, uint64 number of
+ * elements to sort, uint32 ref to the array where the sorting network
+ * is stored.
+ * No return value.
+ *
+ * The layout is the same as for MinMaxTopKSortingNetwork_serialize, but every
+ * number is stored as an uint32, as for CompactSortingNetwork_serialize.
+ */
+SHAREMIND_MODULE_API_0x1_SYSCALL(CompactMinMaxTopKSortingNetwork_serialize,
+                                 args, num_args, refs, crefs,
+                                 returnValue, c)
+{
+    return networkSerialize<uint32_t, MinMaxLayout>(
+                topKSortingNetworkGenerator(c),
+                args, num_args, refs, crefs, returnValue);
+}
+
 } // extern "C" {
@@ -25,5 +25,16 @@
 
 SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(TopKSortingNetwork_serializedSize,)
 SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(TopKSortingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactTopKSortingNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactTopKSortingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(TopKSortingNetwork_cacheStatistics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(TopKSortingNetwork_metrics,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(TopKSortingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactTopKSortingNetwork_allocateAndSerialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(TopKSortingNetwork_prefetch,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MinMaxTopKSortingNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(MinMaxTopKSortingNetwork_serialize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactMinMaxTopKSortingNetwork_serializedSize,)
+SHAREMIND_MOD_ALGORITHMS_DECLARE_SYSCALL(CompactMinMaxTopKSortingNetwork_serialize,)
 
 #endif /* SHAREMIND_MOD_ALGORITHMS_TOPKSORTINGNETWORK_H */
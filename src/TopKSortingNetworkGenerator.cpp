@@ -20,147 +20,484 @@
 #include "TopKSortingNetworkGenerator.h"
 
 #include <algorithm>
-#include <sharemind/DebugOnly.h>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 
 namespace /* anonymous */ {
 
 typedef TopKSortingNetworkGenerator::Network Network;
-typedef TopKSortingNetworkGenerator::Stage Stage;
 
-inline uint64_t logBase2(uint64_t n) {
+/** \returns the smallest m such that 2^m >= n. */
+inline uint64_t ceilLogBase2(uint64_t const n) {
     uint64_t out = 0u;
-    while (n >>= 1u)
+    while (out < 64u && (uint64_t(1u) << out) < n)
         ++out;
     return out;
 }
 
-class PascalStageIterator
-        : public std::iterator<std::input_iterator_tag, uint64_t>
-{
-
-private: /* Methods: */
-
-    inline explicit PascalStageIterator(const uint64_t n)
-        : m_c(1u)
-        , m_n(n)
-        , m_k(1u) {}
+/**
+  \returns the rows [0, rows) of Pascal's triangle.
+  \details Only additions are used, so unlike with the multiplicative formula
+           no intermediate result overflows for any row which fits.
+*/
+std::vector<std::vector<uint64_t> > pascalTriangle(size_t const rows) {
+    std::vector<std::vector<uint64_t> > r(rows);
+    for (size_t n = 0u; n < rows; ++n) {
+        r[n].resize(n + 1u, 1u);
+        for (size_t k = 1u; k < n; ++k)
+            r[n][k] = r[n - 1u][k - 1u] + r[n - 1u][k];
+    }
+    return r;
+}
 
-    inline PascalStageIterator(const uint64_t n, bool)
-        : m_c(1u)
-        , m_n(n)
-        , m_k(n + 2u) {}
+/**
+  \brief A bitset which is operated on a 64-bit word at a time.
+  \details A padding word at the end allows loading any 64 bits beginning at
+           a position of the bitset.
+*/
+class Bitset {
 
 public: /* Methods: */
 
-    inline static PascalStageIterator begin(const uint64_t n)
-        { return PascalStageIterator(n); }
+    explicit Bitset(size_t const size)
+        : m_words(size / 64u + 2u, 0u)
+    {}
 
-    inline static PascalStageIterator end(const uint64_t n)
-        { return PascalStageIterator(n, true); }
+    /** \brief Sets the bits [begin, end). */
+    void set(size_t const begin, size_t const end) noexcept {
+        for (size_t w = begin / 64u; begin < end && w <= (end - 1u) / 64u; ++w)
+            m_words[w] |= mask(w, begin, end);
+    }
 
-    inline uint64_t operator*() const { return m_c; }
-    inline uint64_t operator->() const { return m_c; }
+    /**
+      \brief Sets every bit p in [begin, end) for which bit p - shift of src
+             is set.
+      \details Only the words of the bitset containing positions in
+               [begin, end) are written.
+    */
+    void orShifted(Bitset const & src,
+                   size_t const begin,
+                   size_t const end,
+                   size_t const shift) noexcept
+    {
+        assert(begin >= shift || begin >= end);
+        for (size_t w = begin / 64u; begin < end && w <= (end - 1u) / 64u; ++w)
+        {
+            size_t const first = w * 64u;
+            uint64_t const bits = (first >= shift)
+                                  ? src.load(first - shift)
+                                  : (src.load(0u) << (shift - first));
+            m_words[w] |= bits & mask(w, begin, end);
+        }
+    }
 
-    inline bool operator==(const PascalStageIterator & i) const {
-        return m_k == i.m_k;
+    /** \returns the number of set bits in [begin, end). */
+    size_t count(size_t const begin, size_t const end) const noexcept {
+        size_t r = 0u;
+        for (size_t w = begin / 64u; begin < end && w <= (end - 1u) / 64u; ++w)
+            r += static_cast<size_t>(
+                        __builtin_popcountll(m_words[w] & mask(w, begin, end)));
+        return r;
     }
 
-    inline bool operator!=(const PascalStageIterator & i) const {
-        return m_k != i.m_k;
+    /** \brief Calls f(p) for every set bit p in [begin, end) in order. */
+    template <typename F>
+    void forEachSet(size_t const begin, size_t const end, F && f) const {
+        for (size_t w = begin / 64u; begin < end && w <= (end - 1u) / 64u; ++w)
+        {
+            for (uint64_t bits = m_words[w] & mask(w, begin, end);
+                 bits;
+                 bits &= bits - 1u)
+                f(w * 64u + static_cast<size_t>(__builtin_ctzll(bits)));
+        }
     }
 
-    inline PascalStageIterator & operator++() {
-        m_c *= m_n - m_k + 1u;
-        m_c /= m_k;
-        m_k ++;
-        return *this;
+    void swap(Bitset & other) noexcept { m_words.swap(other.m_words); }
+
+private: /* Methods: */
+
+    /** \returns the bits [pos, pos + 64). */
+    uint64_t load(size_t const pos) const noexcept {
+        size_t const w = pos / 64u;
+        unsigned const shift = pos % 64u;
+        return shift
+               ? ((m_words[w] >> shift) | (m_words[w + 1u] << (64u - shift)))
+               : m_words[w];
     }
 
-    inline PascalStageIterator operator++(int) {
-        PascalStageIterator out = *this;
-        this->operator++();
-        return out;
+    /** \returns the mask of the bits of word w in [begin, end). */
+    static uint64_t mask(size_t const w,
+                         size_t const begin,
+                         size_t const end) noexcept
+    {
+        size_t const first = w * 64u;
+        uint64_t r = ~uint64_t(0u);
+        if (begin > first)
+            r &= ~uint64_t(0u) << (begin - first);
+        if (end < first + 64u)
+            r &= ~(~uint64_t(0u) << (end - first));
+        return r;
     }
 
 private: /* Fields: */
 
-    uint64_t m_c;
-    const uint64_t m_n;
-    uint64_t m_k;
+    std::vector<uint64_t> m_words;
+
+}; /* class Bitset { */
+
+/** The least number of positions worth processing in a separate thread. */
+constexpr size_t minPositionsPerThread = size_t(1u) << 22u;
+
+/**
+  \brief A split of the positions of a tournament into chunks of whole words,
+         which are processed in parallel.
+*/
+struct PositionChunks {
+
+    explicit PositionChunks(size_t const positions) noexcept
+        : positions(positions)
+        , threads(std::max<size_t>(
+                      1u,
+                      std::min<size_t>(std::thread::hardware_concurrency(),
+                                       positions / minPositionsPerThread)))
+        , size((positions / threads + 63u) / 64u * 64u)
+        , count((positions + size - 1u) / size)
+    {}
+
+    size_t begin(size_t const chunk) const noexcept { return chunk * size; }
 
-}; /* class PascalStageIterator */
+    size_t end(size_t const chunk) const noexcept
+    { return std::min(positions, begin(chunk) + size); }
+
+    size_t const positions;
+    size_t const threads;
+    size_t const size;
+    size_t const count;
+
+};
+
+/**
+  \brief A block of a round of the tournament, in which each position j of
+         [offset, offset + half) is compared to position j + half.
+*/
+struct Block {
+
+    /** \returns the end of the positions compared to real elements. */
+    size_t comparedEnd(size_t const elements) const noexcept {
+        assert(half < elements);
+        return std::min(offset + half, elements - half);
+    }
+
+    size_t offset;
+    size_t half;
+
+};
+
+/**
+  \brief Calls f(stage, blocks, need, chunks) for every stage of the network
+         finding the best (for a loose value of best) k of the given number of
+         elements.
+  \details The network is a Swiss tournament on a hypercube of 2^n positions,
+           where n = ceilLogBase2(elements), in which the elements beyond the
+           given ones are virtual and lose every comparison. These never win
+           against a real element, so they stay in their positions, and the
+           comparators involving them are omitted. Comparators which affect
+           none of the first k outputs are omitted as well.
+
+           The comparators of a stage are (j, j + half) for every j in
+           [offset, block.comparedEnd(elements)) of each block for which the
+           bit j of need is set, i.e. whose output of the stage is needed.
+
+           The stages are numbered from the last one to be applied, as the
+           needed outputs are propagated backwards through the rounds. Each
+           round is processed in parallel chunks of positions.
+*/
+template <typename F>
+void forEachPartialSwissStage(uint64_t const elements,
+                              uint64_t const k,
+                              F && f)
+{
+    if (k > elements)
+        throw std::invalid_argument("More outputs than elements requested!");
+    size_t const n = ceilLogBase2(elements);
+    PositionChunks const chunks(size_t(1u) << n);
+    Bitset need(chunks.positions);
+    Bitset needNext(chunks.positions);
+    need.set(0u, k);
+
+    auto const binomials(pascalTriangle(n + 1u));
+    std::vector<Block> blocks;
+    for (size_t r = 1u; r <= n; ++r) {
+        blocks.clear();
+        size_t offset = 0u;
+        for (auto const binomial : binomials[n - r]) {
+            if (offset >= elements)
+                break;
+            size_t const half = binomial << (r - 1u);
+            blocks.push_back(Block{offset, half});
+            offset += 2u * half;
+        }
 
-inline PascalStageIterator beginRow(const uint64_t n) {
-    return PascalStageIterator::begin(n);
+        f(r - 1u, blocks, need, chunks);
+
+        parallelFor(
+                chunks.count,
+                chunks.threads,
+                [&blocks, &need, &needNext, &chunks, elements](
+                        size_t const chunk)
+                {
+                    size_t const begin = chunks.begin(chunk);
+                    size_t const end = chunks.end(chunk);
+                    for (auto const & b : blocks) {
+                        // Winners stay in their positions, also if not
+                        // compared:
+                        needNext.orShifted(
+                                    need,
+                                    std::max(begin, b.offset),
+                                    std::min(end, b.offset + b.half),
+                                    0u);
+                        // Losers come from the compared positions:
+                        needNext.orShifted(
+                                    need,
+                                    std::max(begin, b.offset + b.half),
+                                    std::min<size_t>(
+                                        end,
+                                        b.comparedEnd(elements) + b.half),
+                                    b.half);
+                    }
+                });
+        need.swap(needNext);
+    }
 }
 
-inline PascalStageIterator endRow(const uint64_t n) {
-    return PascalStageIterator::end(n);
+/**
+  \returns the number of comparators in each stage, from the last one to be
+           applied.
+*/
+std::vector<uint64_t> partialSwissStageSizes(uint64_t const elements,
+                                             uint64_t const k)
+{
+    std::vector<uint64_t> r(ceilLogBase2(elements), 0u);
+    forEachPartialSwissStage(
+                elements,
+                k,
+                [&r, elements](size_t const stage,
+                               std::vector<Block> const & blocks,
+                               Bitset const & need,
+                               PositionChunks const &)
+                {
+                    for (auto const & b : blocks)
+                        r[stage] += need.count(b.offset,
+                                               b.comparedEnd(elements));
+                });
+    return r;
 }
 
-// Find the best (for a loose value of best) k from array of length 2^n.
-std::unique_ptr<Network> constructPartialSwissSortingNetwork(
+/**
+  \brief Finds the best (for a loose value of best) k of the elements.
+  \returns the image of the network, see Network.
+  \details The sizes of the stages are counted first, so that the comparators
+           can be written into their final places in the image in parallel.
+*/
+std::unique_ptr<NetworkImage const> constructPartialSwissSortingNetwork(
         uint64_t const elements,
         uint64_t const k)
 {
-    auto stages(std::make_unique<Network>());
-    const uint64_t n = logBase2(elements);
-    Stage stage;
-    std::vector<bool> needToCompute(1 << n);
-    std::vector<bool> needToComputeNext(1 << n);
-
-    for (size_t i = 0; i < k; ++ i)
-        needToCompute.at(i) = true;
-
-    size_t shift = 0;
-    for (size_t r = 1; r <= n; ++ r) {
-        stage.clear();
-        size_t offset = 0;
-        for (PascalStageIterator i = beginRow(n-r), e = endRow(n-r);
-             i != e;
-             ++ i)
-        {
-            const size_t half = *i << shift;
-            for (size_t j = offset; j < half + offset; ++ j) {
-                if (needToCompute[j]) {
-                    stage.push_back(std::make_pair(j, j + half));
-                    needToComputeNext[j] = true;
-                    needToComputeNext[j + half] = true;
-                }
-            }
-
-            offset += half*2;
-        }
-
-        ++shift;
-        swap(needToCompute, needToComputeNext);
+    if (elements > std::numeric_limits<uint32_t>::max() + uint64_t(1u))
+        throw std::length_error("Too many elements for a top-k network!");
+
+    auto const stageSizes(partialSwissStageSizes(elements, k));
+    size_t const stages = stageSizes.size();
+    size_t comparators = 0u;
+    for (auto const size : stageSizes)
+        comparators += size;
+
+    size_t const packedWords = (comparators + 1u) / 2u;
+    std::vector<uint64_t> r(2u + stages + 2u * packedWords, 0u);
+    r[0u] = stages;
+    uint64_t * const offsets = r.data() + 1u;
+    uint64_t * const packedLefts = offsets + stages + 1u;
+    uint64_t * const packedRights = packedLefts + packedWords;
+    for (size_t s = 0u; s < stages; ++s)
+        offsets[s + 1u] = offsets[s] + stageSizes[stages - 1u - s];
+
+    auto const pack = [packedLefts, packedRights](size_t const i,
+                                                  size_t const left,
+                                                  size_t const right)
+    {
+        packedLefts[i / 2u] |= uint64_t(left) << (32u * (i % 2u));
+        packedRights[i / 2u] |= uint64_t(right) << (32u * (i % 2u));
+    };
+    forEachPartialSwissStage(
+                elements,
+                k,
+                [&](size_t const stage,
+                    std::vector<Block> const & blocks,
+                    Bitset const & need,
+                    PositionChunks const & chunks)
+                {
+                    // The index of the first comparator of each chunk:
+                    std::vector<size_t> firsts(chunks.count + 1u, 0u);
+                    firsts[0u] = offsets[stages - 1u - stage];
+                    parallelFor(
+                            chunks.count,
+                            chunks.threads,
+                            [&](size_t const chunk) {
+                                for (auto const & b : blocks)
+                                    firsts[chunk + 1u] += need.count(
+                                            std::max(chunks.begin(chunk),
+                                                     b.offset),
+                                            std::min(chunks.end(chunk),
+                                                     b.comparedEnd(elements)));
+                            });
+                    for (size_t c = 0u; c < chunks.count; ++c)
+                        firsts[c + 1u] += firsts[c];
+
+                    /* A chunk beginning in the middle of a word leaves its
+                       first comparator to be packed after the others, so
+                       that no word is written by two threads: */
+                    std::vector<std::pair<size_t, size_t> > deferred(
+                                chunks.count);
+                    parallelFor(
+                            chunks.count,
+                            chunks.threads,
+                            [&](size_t const chunk) {
+                                size_t i = firsts[chunk];
+                                for (auto const & b : blocks) {
+                                    need.forEachSet(
+                                            std::max(chunks.begin(chunk),
+                                                     b.offset),
+                                            std::min(chunks.end(chunk),
+                                                     b.comparedEnd(elements)),
+                                            [&](size_t const j) {
+                                                if (i == firsts[chunk]
+                                                    && i % 2u)
+                                                {
+                                                    deferred[chunk] =
+                                                            std::make_pair(
+                                                                j,
+                                                                j + b.half);
+                                                } else {
+                                                    pack(i, j, j + b.half);
+                                                }
+                                                ++i;
+                                            });
+                                }
+                                assert(i == firsts[chunk + 1u]);
+                            });
+                    for (size_t c = 0u; c < chunks.count; ++c)
+                        if (firsts[c] % 2u && firsts[c] < firsts[c + 1u])
+                            pack(firsts[c],
+                                 deferred[c].first,
+                                 deferred[c].second);
+                });
+    return std::make_unique<NetworkImage const>(std::move(r));
+}
 
-        stages->push_back(stage);
+/** \returns the metrics of the network without constructing it. */
+NetworkMetrics measurePartialSwissSortingNetwork(uint64_t const elements,
+                                                 uint64_t const k)
+{
+    auto const widths(partialSwissStageSizes(elements, k));
+    NetworkMetrics r{widths.size(), 0u, 0u};
+    for (auto const width : widths) {
+        r.comparators += width;
+        r.maxStageWidth = std::max(r.maxStageWidth, width);
     }
+    return r;
+}
 
-    reverse(stages->begin(), stages->end());
-    return stages;
+/** \returns whether the image is a well-formed top-k network image. */
+bool isValidImage(NetworkImage const & image) noexcept {
+    auto const * const data = image.data();
+    auto const size = image.size();
+    if (size < 2u || data[0u] > size - 2u)
+        return false;
+    auto const stages = data[0u];
+    auto const * const offsets = data + 1u;
+    if (offsets[0u] != 0u)
+        return false;
+    for (uint64_t s = 0u; s < stages; ++s)
+        if (offsets[s + 1u] < offsets[s])
+            return false;
+    auto const comparators = offsets[stages];
+    return comparators <= size
+           && size == 2u + stages + 2u * ((comparators + 1u) / 2u);
+}
+
+/**
+  \returns the name of the network in a NetworkStore. Change the version
+           whenever the generated networks change.
+*/
+std::string storageName(uint64_t const elements, uint64_t const k) {
+    return "TopKSortingNetwork-v3-" + std::to_string(elements) + '-'
+           + std::to_string(k);
 }
 
 } /* namespace anonymous { */
 
 
-Network * TopKSortingNetworkGenerator::getCachedOrGenerateAndCacheNetwork(
+NetworkMetrics Network::metrics() const noexcept {
+    NetworkMetrics r{numStages(), numComparators(), 0u};
+    auto const * const offsets = stageOffsets();
+    for (size_t s = 0u; s < numStages(); ++s)
+        r.maxStageWidth = std::max(r.maxStageWidth,
+                                   offsets[s + 1u] - offsets[s]);
+    return r;
+}
+
+std::shared_ptr<Network const>
+TopKSortingNetworkGenerator::getCachedOrGenerateAndCacheNetwork(
+        const uint64_t elements,
+        const uint64_t k)
+{
+    if (auto r = findBakedNetwork(elements, k))
+        return r;
+    return m_cache.getOrGenerate(
+                std::make_pair(elements, k),
+                [this](std::pair<uint64_t, uint64_t> const & key) {
+                    return loadOrGenerateAndStoreNetwork(key.first,
+                                                         key.second);
+                });
+}
+
+NetworkMetrics TopKSortingNetworkGenerator::networkMetrics(
         const uint64_t elements,
         const uint64_t k)
 {
-    std::pair<uint64_t, uint64_t> key(elements, k);
-
-    std::lock_guard<std::mutex> lock(m_cacheMutex);
-    auto it(m_cache.find(key));
-    if (it != m_cache.cend())
-        return it->second.get();
-    auto sn(constructPartialSwissSortingNetwork(elements, k));
-    auto r(sn.get());
-    SHAREMIND_DEBUG_ONLY(auto const rv =)
-            m_cache.emplace(std::move(key), std::move(sn));
-    assert(rv.second);
+    if (auto const baked = findBakedNetwork(elements, k))
+        return baked->metrics();
+    if (auto const network = m_cache.find(std::make_pair(elements, k)))
+        return network->metrics();
+    return measurePartialSwissSortingNetwork(elements, k);
+}
+
+std::shared_ptr<Network const>
+TopKSortingNetworkGenerator::findBakedNetwork(const uint64_t elements,
+                                              const uint64_t k) const
+{
+    auto const it(m_bakedNetworks.find(std::make_pair(elements, k)));
+    return (it != m_bakedNetworks.cend()) ? it->second : nullptr;
+}
+
+std::shared_ptr<Network const>
+TopKSortingNetworkGenerator::loadOrGenerateAndStoreNetwork(
+        const uint64_t elements,
+        const uint64_t k) const
+{
+    auto const name(storageName(elements, k));
+    if (auto image = m_store.load(name))
+        if (isValidImage(*image))
+            return std::make_shared<Network const>(std::move(image));
+
+    auto r(std::make_shared<Network const>(
+               constructPartialSwissSortingNetwork(elements, k)));
+    m_store.store(name, r->image().data(), r->image().size());
     return r;
 }
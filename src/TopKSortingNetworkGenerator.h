@@ -20,74 +20,281 @@
 #ifndef SHAREMIND_MOD_ALGORITHMS_TOPKSORTINGNETWORKGENERATOR_H
 #define SHAREMIND_MOD_ALGORITHMS_TOPKSORTINGNETWORKGENERATOR_H
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <map>
 #include <memory>
-#include <mutex>
+#include <type_traits>
 #include <utility>
 #include <vector>
+#include "BakedNetworks.h"
+#include "NetworkCache.h"
+#include "NetworkMetrics.h"
+#include "NetworkStore.h"
+#include "ParallelSerialization.h"
 
 
 class __attribute__ ((visibility("internal"))) TopKSortingNetworkGenerator {
 
 public: /* Types: */
 
-    typedef std::vector<std::pair<size_t, size_t> > Stage;
-    class Network: public std::vector<Stage> {
+    /**
+      \brief A top-k sorting network in a compressed sparse row layout.
+      \details The image of the network consists of the number of stages s,
+               s + 1 offsets of the stages into the comparators, and the left
+               and the right indices of all comparators as 32-bit numbers
+               packed two into a word, i.e. 8 bytes per comparator.
+
+               A network is serialized as the number of stages, followed by
+               each stage as the number of comparators in the stage and the
+               pairs of indices compared.
+    */
+    class Network {
 
     public: /* Methods: */
 
-        inline size_t serializedSize() const noexcept {
-            if (m_serializationSize != 0u)
-                return m_serializationSize;
-
-            // First, we would store the number of stages as a single number
-            m_serializationSize = 1u;
-            // Second, we store each stage separately
-            for (size_t s = 0u; s < size(); s++) {
-                // For each stage, we store its size as a single number
-                m_serializationSize++;
-                // Then we store all the indices of the pairs
-                m_serializationSize += 2u * (*this)[s].size();
-            }
-            return m_serializationSize;
+        /**
+           \brief Constructs the network from its validated image.
+        */
+        explicit Network(std::unique_ptr<NetworkImage const> image) noexcept
+            : m_image(std::move(image))
+        {}
+
+        NetworkImage const & image() const noexcept { return *m_image; }
+
+        size_t numStages() const noexcept { return m_image->data()[0u]; }
+
+        size_t numComparators() const noexcept
+        { return stageOffsets()[numStages()]; }
+
+        size_t serializedSize() const noexcept
+        { return 1u + numStages() + 2u * numComparators(); }
+
+        NetworkMetrics metrics() const noexcept;
+
+        /** \returns the memory used by this network in bytes. */
+        size_t memoryUsage() const noexcept
+        { return sizeof(*this) + m_image->memoryUsage(); }
+
+        /**
+           \brief Serializes the network into a buffer of serializedSize()
+                  words.
+           \details Word may be uint64_t, or uint32_t for the compact format
+                    if all indices of the network fit into 32 bits.
+
+                    The comparators are written in a sequential pass, which
+                    is split between threads for large networks.
+        */
+        template <typename Word>
+        void serialize(Word * const ptr) const noexcept {
+            static_assert(std::is_same<Word, uint64_t>::value
+                          || std::is_same<Word, uint32_t>::value,
+                          "Only 64-bit and 32-bit words are supported!");
+            assert(ptr);
+            size_t const stages = numStages();
+            uint64_t const * const offsets = stageOffsets();
+            ptr[0u] = static_cast<Word>(stages);
+            for (size_t s = 0u; s < stages; ++s)
+                ptr[1u + s + 2u * offsets[s]] =
+                        static_cast<Word>(offsets[s + 1u] - offsets[s]);
+
+            uint64_t const * const ls = lefts();
+            uint64_t const * const rs = rights();
+            forEachComparator(
+                    serializedSize(),
+                    [ptr, ls, rs](size_t const s,
+                                  size_t const i,
+                                  size_t const,
+                                  size_t const)
+                    {
+                        Word * const out = ptr + 2u + s + 2u * i;
+                        out[0u] = static_cast<Word>(packedIndex(ls, i));
+                        out[1u] = static_cast<Word>(packedIndex(rs, i));
+                    });
         }
 
-        void serialize(uint64_t * const ptr) const noexcept {
+        size_t sortingNetworkSerializedSize() const noexcept
+        { return 1u + numStages() + 4u * numComparators(); }
+
+        /**
+           \brief Serializes the network into a buffer of
+                  sortingNetworkSerializedSize() words in the format of
+                  SerializableNetwork, i.e. of the sorting networks.
+           \details The winner of every comparator stays on its left wire,
+                    which is the target of its minimum. Hence the routine
+                    applying sorting networks leaves the k smallest elements
+                    at the front, or the k largest ones if its comparison is
+                    reversed.
+
+                    Word is as for serialize().
+        */
+        template <typename Word>
+        void serializeAsSortingNetwork(Word * const ptr) const noexcept {
+            static_assert(std::is_same<Word, uint64_t>::value
+                          || std::is_same<Word, uint32_t>::value,
+                          "Only 64-bit and 32-bit words are supported!");
             assert(ptr);
-            size_t offset = 0u;
-
-            // First, we store the number of stages
-            ptr[offset++] = static_cast<uint64_t>(size());
-            // Second, we store each stage separately
-            for (size_t s = 0u; s < size(); s++) {
-                // For each stage, we store its size as a single number
-                ptr[offset++] = static_cast<uint64_t>((*this)[s].size());
-
-                // Store left and right indices
-                for (size_t p = 0u; p < (*this)[s].size(); p++) {
-                    ptr[offset++] = (*this)[s].at(p).first;
-                    ptr[offset++] = (*this)[s].at(p).second;
-                }
-            }
+            size_t const stages = numStages();
+            uint64_t const * const offsets = stageOffsets();
+            ptr[0u] = static_cast<Word>(stages);
+            for (size_t s = 0u; s < stages; ++s)
+                ptr[1u + s + 4u * offsets[s]] =
+                        static_cast<Word>(offsets[s + 1u] - offsets[s]);
+
+            uint64_t const * const ls = lefts();
+            uint64_t const * const rs = rights();
+            forEachComparator(
+                    sortingNetworkSerializedSize(),
+                    [ptr, ls, rs](size_t const s,
+                                  size_t const i,
+                                  size_t const first,
+                                  size_t const width)
+                    {
+                        Word * const out =
+                                ptr + 2u + s + 4u * first + (i - first);
+                        Word const left = static_cast<Word>(packedIndex(ls, i));
+                        Word const right =
+                                static_cast<Word>(packedIndex(rs, i));
+                        out[0u] = left;
+                        out[width] = right;
+                        out[2u * width] = left;
+                        out[3u * width] = right;
+                    });
+        }
+
+    private: /* Methods: */
+
+        /**
+           \brief Calls f(stage, i, first, width) for every comparator i, where
+                  first is the first comparator and width the number of
+                  comparators of its stage.
+           \details The comparators are split into chunks of consecutive
+                    comparators, which are processed in parallel if the
+                    output of the given number of words is large.
+        */
+        template <typename F>
+        void forEachComparator(size_t const outputWords, F const & f)
+                const noexcept
+        {
+            uint64_t const * const offsets = stageOffsets();
+            size_t const comparators = numComparators();
+            size_t const chunks = serializationThreads(outputWords);
+            parallelFor(
+                    chunks,
+                    chunks,
+                    [this, &f, offsets, comparators, chunks](
+                            size_t const chunk)
+                    {
+                        size_t const begin = comparators / chunks * chunk;
+                        size_t const end = (chunk + 1u == chunks)
+                                           ? comparators
+                                           : begin + comparators / chunks;
+                        size_t s = static_cast<size_t>(
+                                    std::upper_bound(offsets,
+                                                     offsets + numStages(),
+                                                     begin)
+                                    - offsets) - 1u;
+                        for (size_t i = begin; i < end; ++i) {
+                            while (offsets[s + 1u] <= i)
+                                ++s;
+                            f(s,
+                              i,
+                              offsets[s],
+                              offsets[s + 1u] - offsets[s]);
+                        }
+                    });
         }
 
+        uint64_t const * stageOffsets() const noexcept
+        { return m_image->data() + 1u; }
+
+        uint64_t const * lefts() const noexcept
+        { return stageOffsets() + numStages() + 1u; }
+
+        uint64_t const * rights() const noexcept
+        { return lefts() + (numComparators() + 1u) / 2u; }
+
+        /** \returns the i-th of the 32-bit numbers packed into words. */
+        static uint64_t packedIndex(uint64_t const * const words,
+                                    size_t const i) noexcept
+        { return (words[i / 2u] >> (32u * (i % 2u))) & 0xffffffffu; }
+
     private: /* Fields: */
 
-        mutable size_t m_serializationSize = 0u;
+        std::unique_ptr<NetworkImage const> const m_image;
 
     };
 
+    using CacheStatistics =
+            NetworkCache<std::pair<uint64_t, uint64_t>, Network>::Statistics;
+
+    using BakedNetworks = std::map<std::pair<uint64_t, uint64_t>,
+                                   std::shared_ptr<Network const> >;
+
 public: /* Methods: */
 
-    Network * getCachedOrGenerateAndCacheNetwork(const uint64_t elements,
-                                                 const uint64_t k);
+    /**
+       \param[in] cacheBudget The budget of the memory of the cached networks.
+       \param[in] store The store for persisting the generated networks.
+       \param[in] bakedNetworks The networks baked into the module, which are
+                               returned without locking and do not count
+                               towards the cache statistics.
+    */
+    TopKSortingNetworkGenerator(NetworkCacheBudget & cacheBudget,
+                                NetworkStore const & store,
+                                BakedNetworks bakedNetworks = BakedNetworks())
+        : m_bakedNetworks(std::move(bakedNetworks))
+        , m_cache(cacheBudget)
+        , m_store(store)
+    {}
+
+    /** \brief Loads the networks baked into the module. */
+    static BakedNetworks loadBakedNetworks() {
+        BakedNetworks r;
+        for (size_t elements = 1u;
+             elements <= maxBakedNetworkElements;
+             ++elements)
+        {
+            for (size_t k = 1u; k <= maxBakedTopKSortingNetworkK; ++k) {
+                BakedNetwork const baked(bakedTopKSortingNetwork(elements, k));
+                if (baked.data)
+                    r.emplace(std::make_pair(elements, k),
+                              std::make_shared<Network const>(
+                                  std::make_unique<NetworkImage const>(
+                                      baked.data,
+                                      baked.size)));
+            }
+        }
+        return r;
+    }
+
+    std::shared_ptr<Network const> getCachedOrGenerateAndCacheNetwork(
+            const uint64_t elements,
+            const uint64_t k);
+
+    /**
+       \brief Returns the metrics of the network, which is neither generated
+              nor cached for this if it is not cached already.
+    */
+    NetworkMetrics networkMetrics(const uint64_t elements, const uint64_t k);
+
+    CacheStatistics cacheStatistics() const { return m_cache.statistics(); }
+
+private: /* Methods: */
+
+    std::shared_ptr<Network const> findBakedNetwork(const uint64_t elements,
+                                                    const uint64_t k) const;
+
+    std::shared_ptr<Network const> loadOrGenerateAndStoreNetwork(
+            const uint64_t elements,
+            const uint64_t k) const;
 
 private: /* Fields: */
 
-    mutable std::mutex m_cacheMutex;
-    std::map<std::pair<uint64_t, uint64_t>, std::unique_ptr<Network> > m_cache;
+    BakedNetworks const m_bakedNetworks;
+    NetworkCache<std::pair<uint64_t, uint64_t>, Network> m_cache;
+    NetworkStore const & m_store;
 
 }; /* class TopKSortingNetworkGenerator { */
 
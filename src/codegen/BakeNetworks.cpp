@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2015 Cybernetica
+ *
+ * Research/Commercial License Usage
+ * Licensees holding a valid Research License or Commercial License
+ * for the Software may use this file according to the written
+ * agreement between you and Cybernetica.
+ *
+ * GNU General Public License Usage
+ * Alternatively, this file may be used under the terms of the GNU
+ * General Public License version 3.0 as published by the Free Software
+ * Foundation and appearing in the file LICENSE.GPL included in the
+ * packaging of this file.  Please review the following information to
+ * ensure the GNU General Public License version 3.0 requirements will be
+ * met: http://www.gnu.org/copyleft/gpl-3.0.html.
+ *
+ * For further information, please contact us at sharemind@cyber.ee.
+ */
+
+/*
+  Generates the source of the networks baked into the module, see
+  BakedNetworks.h. Usage: BakeNetworks <output file>
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../BakedNetworks.h"
+#include "../NetworkStore.h"
+#include "../SortingNetworkGenerator.h"
+#include "../TopKSortingNetworkGenerator.h"
+
+
+namespace {
+
+class SourceWriter {
+
+public: /* Methods: */
+
+    explicit SourceWriter(std::ostream & out) noexcept : m_out(out) {}
+
+    /** \returns the initializer of the BakedNetwork for the table. */
+    std::string writeTable(std::string name, NetworkImage const & image) {
+        m_out << "constexpr std::uint64_t " << name << "[] = {";
+        std::size_t column = 80u;
+        for (std::size_t i = 0u; i < image.size(); ++i) {
+            auto const word(std::to_string(image.data()[i]) + "u");
+            if (column + word.size() + 2u > 80u) {
+                m_out << "\n   ";
+                column = 3u;
+            }
+            m_out << ' ' << word << ',';
+            column += word.size() + 2u;
+        }
+        m_out << "\n};\n\n";
+        return name + ", " + std::to_string(image.size()) + "u";
+    }
+
+    void writeIndex(std::string const & name,
+                    std::string const & dimensions,
+                    std::vector<std::string> const & entries)
+    {
+        m_out << "constexpr BakedNetwork " << name << dimensions << " = {\n";
+        for (auto const & entry : entries)
+            m_out << "    { " << entry << " },\n";
+        m_out << "};\n\n";
+    }
+
+private: /* Fields: */
+
+    std::ostream & m_out;
+
+};
+
+template <typename T>
+std::vector<std::string> writeNetworks(SourceWriter & writer,
+                                       std::string const & name)
+{
+    std::vector<std::string> r(1u, "nullptr, 0u");
+    for (std::size_t n = 1u; n <= maxBakedNetworkElements; ++n) {
+        T const network(n);
+        r.emplace_back(writer.writeTable(name + std::to_string(n),
+                                         network.image()));
+    }
+    return r;
+}
+
+/**
+  \returns whether BitonicSortingNetwork::modelMetrics() agrees with the
+           generated networks of all numbers of elements up to 1024 and of
+           some numbers around the larger powers of two up to 65536.
+*/
+bool checkBitonicMetricsModel() {
+    std::vector<std::size_t> sizes;
+    for (std::size_t n = 0u; n <= 1024u; ++n)
+        sizes.push_back(n);
+    for (std::size_t p = 2048u; p <= 65536u; p *= 2u)
+        for (std::size_t const n : {p - 1u, p, p + 1u, p + p / 2u})
+            sizes.push_back(n);
+
+    for (auto const n : sizes) {
+        auto const model(BitonicSortingNetwork::modelMetrics(n));
+        auto const metrics(BitonicSortingNetwork(n).metrics());
+        if (model.depth != metrics.depth
+            || model.comparators != metrics.comparators
+            || model.maxStageWidth != metrics.maxStageWidth)
+        {
+            std::fprintf(stderr,
+                         "BakeNetworks: The modelled metrics of the bitonic "
+                         "sorting network for %zu elements are wrong, so "
+                         "the networks will be generated for measuring "
+                         "them.\n",
+                         n);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char * argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <output file>\n", argv[0u]);
+        return 1;
+    }
+
+    std::ofstream out(argv[1u]);
+    out << "// Generated by BakeNetworks, do not edit.\n\n"
+           "#include \"BakedNetworks.h\"\n\n\n"
+           "namespace {\n\n";
+    SourceWriter writer(out);
+
+    // Indexed by the SortingNetworkAlgorithm and the number of elements:
+    std::vector<std::string> sortingNetworks;
+    for (auto const & names : writeNetworks<BitonicSortingNetwork>(
+                                    writer, "bitonicSortingNetwork"))
+        sortingNetworks.emplace_back(names);
+    for (auto const & names : writeNetworks<OddEvenMergeSortingNetwork>(
+                                    writer, "oddEvenMergeSortingNetwork"))
+        sortingNetworks.emplace_back(names);
+    for (auto const & names : writeNetworks<PairwiseSortingNetwork>(
+                                    writer, "pairwiseSortingNetwork"))
+        sortingNetworks.emplace_back(names);
+    std::size_t const bakedSortingAlgorithms = 3u;
+    writer.writeIndex("sortingNetworks",
+                      "[" + std::to_string(sortingNetworks.size()) + "]",
+                      sortingNetworks);
+    auto const mergingNetworks(
+            writeNetworks<MergingNetwork>(writer, "mergingNetwork"));
+    writer.writeIndex("mergingNetworks",
+                      "[" + std::to_string(mergingNetworks.size()) + "]",
+                      mergingNetworks);
+
+    // Indexed by the number of elements and k:
+    NetworkStore const noStore{std::string()};
+    NetworkCacheBudget unlimited;
+    TopKSortingNetworkGenerator topKGenerator(unlimited, noStore);
+    std::vector<std::string> topKSortingNetworks;
+    for (std::size_t n = 0u; n <= maxBakedNetworkElements; ++n) {
+        for (std::size_t k = 0u; k <= maxBakedTopKSortingNetworkK; ++k) {
+            // Networks exist for k up to n:
+            if (n == 0u || k == 0u || k > n) {
+                topKSortingNetworks.emplace_back("nullptr, 0u");
+                continue;
+            }
+            auto const network(
+                    topKGenerator.getCachedOrGenerateAndCacheNetwork(n, k));
+            topKSortingNetworks.emplace_back(
+                    writer.writeTable("topKSortingNetwork"
+                                      + std::to_string(n) + "_"
+                                      + std::to_string(k),
+                                      network->image()));
+        }
+    }
+    writer.writeIndex("topKSortingNetworks",
+                      "[" + std::to_string(topKSortingNetworks.size()) + "]",
+                      topKSortingNetworks);
+
+    out << "} // anonymous namespace\n\n"
+           "BakedNetwork bakedSortingNetwork(std::uint64_t const algorithm,\n"
+           "                                 std::size_t const elements)"
+           " noexcept\n"
+           "{\n"
+           "    if (algorithm >= " << bakedSortingAlgorithms
+        << "u || elements > maxBakedNetworkElements)\n"
+           "        return BakedNetwork{nullptr, 0u};\n"
+           "    return sortingNetworks[algorithm * (maxBakedNetworkElements"
+           " + 1u)\n"
+           "                           + elements];\n"
+           "}\n\n"
+           "BakedNetwork bakedMergingNetwork(std::size_t const elements)"
+           " noexcept {\n"
+           "    if (elements > maxBakedNetworkElements)\n"
+           "        return BakedNetwork{nullptr, 0u};\n"
+           "    return mergingNetworks[elements];\n"
+           "}\n\n"
+           "BakedNetwork bakedTopKSortingNetwork(std::size_t const elements,\n"
+           "                                     std::size_t const k)"
+           " noexcept\n"
+           "{\n"
+           "    if (elements > maxBakedNetworkElements\n"
+           "        || k > maxBakedTopKSortingNetworkK)\n"
+           "        return BakedNetwork{nullptr, 0u};\n"
+           "    return topKSortingNetworks[elements\n"
+           "                               * (maxBakedTopKSortingNetworkK"
+           " + 1u)\n"
+           "                               + k];\n"
+           "}\n\n"
+           "bool bitonicMetricsModelVerified() noexcept {\n"
+           "    return " << (checkBitonicMetricsModel() ? "true" : "false")
+        << ";\n"
+           "}\n";
+    out.close();
+    return out ? 0 : 1;
+}
@@ -24,6 +24,7 @@
 #include "BlockSortPermutation.h"
 #include "CatchModuleApiErrors.h"
 #include "Misc.h"
+#include "ModuleConfiguration.h"
 #include "ModuleData.h"
 #include "Log.h"
 #include "Sine.h"
@@ -43,8 +44,10 @@ SHAREMIND_MODULE_API_0x1_INITIALIZER(c) __attribute__ ((visibility("default")));
 SHAREMIND_MODULE_API_0x1_INITIALIZER(c) {
     assert(c);
     try {
-        c->moduleHandle = new ModuleData();
+        c->moduleHandle = new ModuleData(ModuleConfiguration(c->conf));
         return SHAREMIND_MODULE_API_0x1_OK;
+    } catch (ModuleConfiguration::Exception const &) {
+        return SHAREMIND_MODULE_API_0x1_INVALID_MODULE_CONFIGURATION;
     } catch (...) {
         return catchModuleApiErrors();
     }
@@ -94,8 +97,58 @@ SHAREMIND_MODULE_API_0x1_SYSCALL_DEFINITIONS(
     SAMENAME(SortingNetwork_serialize),
     SAMENAME(MergingNetwork_serializedSize),
     SAMENAME(MergingNetwork_serialize),
+    SAMENAME(SortingNetwork_numStages),
+    SAMENAME(SortingNetwork_serializedStagesSize),
+    SAMENAME(SortingNetwork_serializeStages),
+    SAMENAME(MergingNetwork_numStages),
+    SAMENAME(MergingNetwork_serializedStagesSize),
+    SAMENAME(MergingNetwork_serializeStages),
     SAMENAME(TopKSortingNetwork_serializedSize),
     SAMENAME(TopKSortingNetwork_serialize),
+    SAMENAME(CompactSortingNetwork_serializedSize),
+    SAMENAME(CompactSortingNetwork_serialize),
+    SAMENAME(CompactMergingNetwork_serializedSize),
+    SAMENAME(CompactMergingNetwork_serialize),
+    SAMENAME(CompactTopKSortingNetwork_serializedSize),
+    SAMENAME(CompactTopKSortingNetwork_serialize),
+    SAMENAME(SortingNetwork_cacheStatistics),
+    SAMENAME(MergingNetwork_cacheStatistics),
+    SAMENAME(TopKSortingNetwork_cacheStatistics),
+    SAMENAME(SortingNetwork_selectAlgorithm),
+    SAMENAME(UnequalMergingNetwork_serializedSize),
+    SAMENAME(UnequalMergingNetwork_serialize),
+    SAMENAME(MultiwayMergingNetwork_serializedSize),
+    SAMENAME(MultiwayMergingNetwork_serialize),
+    SAMENAME(SortingNetwork_metrics),
+    SAMENAME(MergingNetwork_metrics),
+    SAMENAME(UnequalMergingNetwork_metrics),
+    SAMENAME(MultiwayMergingNetwork_metrics),
+    SAMENAME(TopKSortingNetwork_metrics),
+    SAMENAME(SortingNetwork_allocateAndSerialize),
+    SAMENAME(CompactSortingNetwork_allocateAndSerialize),
+    SAMENAME(MergingNetwork_allocateAndSerialize),
+    SAMENAME(CompactMergingNetwork_allocateAndSerialize),
+    SAMENAME(UnequalMergingNetwork_allocateAndSerialize),
+    SAMENAME(MultiwayMergingNetwork_allocateAndSerialize),
+    SAMENAME(TopKSortingNetwork_allocateAndSerialize),
+    SAMENAME(CompactTopKSortingNetwork_allocateAndSerialize),
+    SAMENAME(SortingNetwork_prefetch),
+    SAMENAME(MergingNetwork_prefetch),
+    SAMENAME(UnequalMergingNetwork_prefetch),
+    SAMENAME(MultiwayMergingNetwork_prefetch),
+    SAMENAME(TopKSortingNetwork_prefetch),
+    SAMENAME(PermutationNetwork_serializedSize),
+    SAMENAME(PermutationNetwork_serialize),
+    SAMENAME(PermutationNetwork_switchSettings),
+    SAMENAME(PermutationNetwork_cacheStatistics),
+    SAMENAME(SelectionNetwork_serializedSize),
+    SAMENAME(SelectionNetwork_serialize),
+    SAMENAME(SelectionNetwork_metrics),
+    SAMENAME(SelectionNetwork_cacheStatistics),
+    SAMENAME(MinMaxTopKSortingNetwork_serializedSize),
+    SAMENAME(MinMaxTopKSortingNetwork_serialize),
+    SAMENAME(CompactMinMaxTopKSortingNetwork_serializedSize),
+    SAMENAME(CompactMinMaxTopKSortingNetwork_serialize),
 
     // Misc. syscalls:
     SAMENAME(sleepMilliseconds),